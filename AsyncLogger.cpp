@@ -0,0 +1,85 @@
+#include "AsyncLogger.h"
+
+#include <cstring>
+
+using OpenEngine::Logging::Error;
+using OpenEngine::Logging::Warning;
+using OpenEngine::Logging::Info;
+
+AsyncLogger::AsyncLogger(ostream* stream)
+    : stream(stream)
+    , running(true)
+    , written(0)
+    , dropped(0)
+{
+    timer.Start();
+    Start();
+}
+
+AsyncLogger::~AsyncLogger() {
+    Stop();
+}
+
+void AsyncLogger::Write(LoggerType type, string msg) {
+    Record r;
+    r.type = type;
+    r.time = timer.GetElapsedTime().AsInt();
+    r.length = msg.size() < MAX_LENGTH ? msg.size() : MAX_LENGTH;
+    memcpy(r.text, msg.data(), r.length);
+    if (ring.Push(r))
+        LOCKFREE_ADD(&written, 1);
+    else
+        LOCKFREE_ADD(&dropped, 1);
+}
+
+void AsyncLogger::Print(const Record& r) {
+    switch (r.type) {
+    case Error:   *stream << "[ERROR] ";   break;
+    case Warning: *stream << "[WARNING] "; break;
+    case Info:    *stream << "[INFO] ";    break;
+    default: break;
+    }
+    unsigned int ms = r.time / 1000;
+    *stream << ms / 1000 << ".";
+    stream->width(3);
+    stream->fill('0');
+    *stream << ms % 1000 << ": ";
+    stream->write(r.text, r.length);
+    if (r.length == MAX_LENGTH) *stream << "...";
+    *stream << '\n';
+}
+
+void AsyncLogger::Run() {
+    Record r;
+    for (;;) {
+        bool wrote = false;
+        while (ring.Pop(r)) {
+            Print(r);
+            wrote = true;
+        }
+        if (wrote)
+            stream->flush();
+        else if (!running)
+            break;
+        else
+            Thread::Sleep(1000);
+    }
+}
+
+// Writes what is left in the ring and ends the logging thread.
+void AsyncLogger::Stop() {
+    if (!running) return;
+    running = false;
+    Wait();
+    if (dropped > 0)
+        *stream << "[WARNING] " << dropped
+                << " log messages dropped, the log ring was full" << std::endl;
+}
+
+unsigned int AsyncLogger::GetWrittenCount() const {
+    return written;
+}
+
+unsigned int AsyncLogger::GetDroppedCount() const {
+    return dropped;
+}
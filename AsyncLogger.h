@@ -0,0 +1,76 @@
+// Logger writing from a background thread.
+// -------------------------------------------------------------------
+// Copyright (C) 2007 OpenEngine.dk (See AUTHORS)
+//
+// This program is free software; It is covered by the GNU General
+// Public License version 2 or any later version.
+// See the GNU General Public License for more details (see LICENSE).
+//--------------------------------------------------------------------
+
+#ifndef _ASYNC_LOGGER_
+#define _ASYNC_LOGGER_
+
+#include <Core/Thread.h>
+#include <Logging/ILogger.h>
+#include <Utils/Timer.h>
+
+#include "LockFree.h"
+
+#include <ostream>
+#include <string>
+
+using OpenEngine::Core::Thread;
+using OpenEngine::Logging::ILogger;
+using OpenEngine::Logging::LoggerType;
+using OpenEngine::Utils::Timer;
+using std::ostream;
+using std::string;
+
+/**
+ * Logger that hands the messages to a background thread instead of
+ * writing them to the stream itself, as a replacement for the
+ * StreamLogger.
+ *
+ * Write copies the message into a record of a lock free ring buffer
+ * and returns, from any number of threads. The logging thread takes
+ * the records out in order, formats and writes them, and flushes the
+ * stream whenever the ring runs empty. Messages are cut at
+ * MAX_LENGTH characters, and when the ring is full a message is
+ * dropped and counted rather than waiting for the logging thread.
+ * Deleting the logger writes everything still in the ring.
+ */
+class AsyncLogger : public ILogger, public Thread {
+public:
+    static const unsigned int CAPACITY = 4096;
+    static const unsigned int MAX_LENGTH = 240;
+
+private:
+    struct Record {
+        LoggerType type;
+        unsigned int time;
+        unsigned int length;
+        char text[MAX_LENGTH];
+    };
+
+    ostream* stream;
+    LockFreeRing<Record, CAPACITY> ring;
+    Timer timer;
+    volatile bool running;
+    volatile int written;
+    volatile int dropped;
+
+    void Print(const Record& record);
+
+public:
+    AsyncLogger(ostream* stream);
+    virtual ~AsyncLogger();
+
+    void Write(LoggerType type, string msg);
+    void Run();
+    void Stop();
+
+    unsigned int GetWrittenCount() const;
+    unsigned int GetDroppedCount() const;
+};
+
+#endif
@@ -0,0 +1,338 @@
+#include "CollisionTree.h"
+
+#include <Geometry/FaceSet.h>
+#include <Logging/Logger.h>
+#include <Scene/GeometryNode.h>
+
+#include <algorithm>
+#include <cfloat>
+#include <cstring>
+#include <fstream>
+
+using OpenEngine::Geometry::FaceList;
+using OpenEngine::Geometry::FaceSet;
+using OpenEngine::Scene::GeometryNode;
+using std::ifstream;
+using std::ofstream;
+using std::ios;
+
+namespace {
+const char MAGIC[4] = { 'O', 'E', 'C', 'T' };
+
+// Entries of the traversal stacks of the queries
+const unsigned int STACK_SIZE = 64;
+
+void CollectTriangles(ISceneNode* node, vector<CollisionTree::Triangle>& tris) {
+    GeometryNode* geom = dynamic_cast<GeometryNode*>(node);
+    if (geom != NULL && geom->GetFaceSet() != NULL) {
+        FaceSet* fs = geom->GetFaceSet();
+        for (FaceList::iterator itr = fs->begin(); itr != fs->end(); itr++) {
+            CollisionTree::Triangle t;
+            for (int v = 0; v < 3; v++)
+                for (int k = 0; k < 3; k++)
+                    t.v[v][k] = (*itr)->vert[v][k];
+            tris.push_back(t);
+        }
+    }
+    for (unsigned int i = 0; i < node->GetNumberOfNodes(); i++)
+        CollectTriangles(node->GetNode(i), tris);
+}
+
+// Orders triangle indices by their center along one axis
+struct CenterLess {
+    const vector<float>& centers;
+    int axis;
+    CenterLess(const vector<float>& centers, int axis)
+        : centers(centers), axis(axis) {}
+    bool operator()(unsigned int a, unsigned int b) const {
+        return centers[a * 3 + axis] < centers[b * 3 + axis];
+    }
+};
+
+bool Overlaps(const float* min1, const float* max1,
+              const float* min2, const float* max2) {
+    return min1[0] <= max2[0] && max1[0] >= min2[0] &&
+           min1[1] <= max2[1] && max1[1] >= min2[1] &&
+           min1[2] <= max2[2] && max1[2] >= min2[2];
+}
+
+// Slab test, returns the entry distance or -1 for a miss
+float RayBox(const float o[3], const float inv[3],
+             const float min[3], const float max[3], float limit) {
+    float t0 = 0, t1 = limit;
+    for (int k = 0; k < 3; k++) {
+        float a = (min[k] - o[k]) * inv[k];
+        float b = (max[k] - o[k]) * inv[k];
+        if (a > b) std::swap(a, b);
+        t0 = std::max(t0, a);
+        t1 = std::min(t1, b);
+        if (t0 > t1) return -1;
+    }
+    return t0;
+}
+
+// Moller-Trumbore, returns the distance or -1 for a miss
+float RayTriangle(const float o[3], const float d[3],
+                  const CollisionTree::Triangle& t) {
+    float e1[3], e2[3], p[3], s[3], q[3];
+    for (int k = 0; k < 3; k++) {
+        e1[k] = t.v[1][k] - t.v[0][k];
+        e2[k] = t.v[2][k] - t.v[0][k];
+    }
+    p[0] = d[1]*e2[2] - d[2]*e2[1];
+    p[1] = d[2]*e2[0] - d[0]*e2[2];
+    p[2] = d[0]*e2[1] - d[1]*e2[0];
+    float det = e1[0]*p[0] + e1[1]*p[1] + e1[2]*p[2];
+    if (det > -1e-9f && det < 1e-9f) return -1;
+    float inv = 1 / det;
+    for (int k = 0; k < 3; k++) s[k] = o[k] - t.v[0][k];
+    float u = (s[0]*p[0] + s[1]*p[1] + s[2]*p[2]) * inv;
+    if (u < 0 || u > 1) return -1;
+    q[0] = s[1]*e1[2] - s[2]*e1[1];
+    q[1] = s[2]*e1[0] - s[0]*e1[2];
+    q[2] = s[0]*e1[1] - s[1]*e1[0];
+    float v = (d[0]*q[0] + d[1]*q[1] + d[2]*q[2]) * inv;
+    if (v < 0 || u + v > 1) return -1;
+    return (e2[0]*q[0] + e2[1]*q[1] + e2[2]*q[2]) * inv;
+}
+}
+
+CollisionTree::CollisionTree(unsigned int leafSize)
+    : leafSize(leafSize)
+{}
+
+void CollisionTree::Clear() {
+    nodes.clear();
+    triangles.clear();
+}
+
+void CollisionTree::Build(ISceneNode& scene) {
+    Clear();
+    CollectTriangles(&scene, triangles);
+    if (triangles.empty()) return;
+
+    vector<float> centers(triangles.size() * 3);
+    for (unsigned int i = 0; i < triangles.size(); i++)
+        for (int k = 0; k < 3; k++)
+            centers[i * 3 + k] = (triangles[i].v[0][k] + triangles[i].v[1][k]
+                                  + triangles[i].v[2][k]) / 3;
+    nodes.reserve(2 * triangles.size() / leafSize + 1);
+    Build(0, triangles.size(), centers);
+}
+
+// Builds the subtree of triangles [first, first+count) and returns
+// its node index. Triangles are reordered in place.
+unsigned int CollisionTree::Build(unsigned int first, unsigned int count,
+                                  vector<float>& centers) {
+    unsigned int index = nodes.size();
+    nodes.push_back(Node());
+    Node n;
+    for (int k = 0; k < 3; k++) {
+        n.min[k] = FLT_MAX;
+        n.max[k] = -FLT_MAX;
+    }
+    float cmin[3] = { FLT_MAX, FLT_MAX, FLT_MAX };
+    float cmax[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+    for (unsigned int i = first; i < first + count; i++)
+        for (int k = 0; k < 3; k++) {
+            for (int v = 0; v < 3; v++) {
+                n.min[k] = std::min(n.min[k], triangles[i].v[v][k]);
+                n.max[k] = std::max(n.max[k], triangles[i].v[v][k]);
+            }
+            cmin[k] = std::min(cmin[k], centers[i * 3 + k]);
+            cmax[k] = std::max(cmax[k], centers[i * 3 + k]);
+        }
+
+    int axis = 0;
+    for (int k = 1; k < 3; k++)
+        if (cmax[k] - cmin[k] > cmax[axis] - cmin[axis]) axis = k;
+
+    if (count <= leafSize || cmax[axis] - cmin[axis] <= 0) {
+        n.offset = first;
+        n.count = count;
+        nodes[index] = n;
+        return index;
+    }
+
+    // Median split, applied to the triangles and their centers
+    vector<unsigned int> order(count);
+    for (unsigned int i = 0; i < count; i++) order[i] = first + i;
+    unsigned int half = count / 2;
+    std::nth_element(order.begin(), order.begin() + half, order.end(),
+                     CenterLess(centers, axis));
+    vector<Triangle> tris(count);
+    vector<float> cs(count * 3);
+    for (unsigned int i = 0; i < count; i++) {
+        tris[i] = triangles[order[i]];
+        for (int k = 0; k < 3; k++) cs[i * 3 + k] = centers[order[i] * 3 + k];
+    }
+    std::copy(tris.begin(), tris.end(), triangles.begin() + first);
+    std::copy(cs.begin(), cs.end(), centers.begin() + first * 3);
+
+    Build(first, half, centers);
+    n.offset = Build(first + half, count - half, centers);
+    n.count = 0;
+    nodes[index] = n;
+    return index;
+}
+
+unsigned int CollisionTree::GetNodeCount() const {
+    return nodes.size();
+}
+
+unsigned int CollisionTree::GetLeafSize() const {
+    return leafSize;
+}
+
+unsigned int CollisionTree::GetTriangleCount() const {
+    return triangles.size();
+}
+
+unsigned long CollisionTree::GetMemory() const {
+    return nodes.size() * sizeof(Node) + triangles.size() * sizeof(Triangle);
+}
+
+// Triangles whose bounds overlap the box. Their indices are added
+// to hits if given.
+unsigned int CollisionTree::QueryBox(const float min[3], const float max[3],
+                                     vector<unsigned int>* hits) const {
+    if (nodes.empty()) return 0;
+    unsigned int found = 0;
+    unsigned int stack[STACK_SIZE];
+    unsigned int top = 0;
+    stack[top++] = 0;
+    while (top > 0) {
+        const Node& n = nodes[stack[--top]];
+        if (!Overlaps(n.min, n.max, min, max)) continue;
+        if (n.count == 0) {
+            stack[top++] = n.offset;
+            stack[top++] = &n - &nodes[0] + 1;
+            continue;
+        }
+        for (unsigned int i = n.offset; i < n.offset + n.count; i++) {
+            const Triangle& t = triangles[i];
+            float tmin[3], tmax[3];
+            for (int k = 0; k < 3; k++) {
+                tmin[k] = std::min(t.v[0][k], std::min(t.v[1][k], t.v[2][k]));
+                tmax[k] = std::max(t.v[0][k], std::max(t.v[1][k], t.v[2][k]));
+            }
+            if (!Overlaps(tmin, tmax, min, max)) continue;
+            found++;
+            if (hits != NULL) hits->push_back(i);
+        }
+    }
+    return found;
+}
+
+// Closest hit along the ray within distance. On a hit distance is
+// set to the hit distance.
+bool CollisionTree::RayCast(const float origin[3], const float direction[3],
+                            float& distance) const {
+    if (nodes.empty()) return false;
+    float inv[3];
+    for (int k = 0; k < 3; k++)
+        inv[k] = direction[k] != 0 ? 1 / direction[k] : FLT_MAX;
+    bool hit = false;
+    unsigned int stack[STACK_SIZE];
+    unsigned int top = 0;
+    stack[top++] = 0;
+    while (top > 0) {
+        const Node& n = nodes[stack[--top]];
+        if (RayBox(origin, inv, n.min, n.max, distance) < 0) continue;
+        if (n.count == 0) {
+            stack[top++] = n.offset;
+            stack[top++] = &n - &nodes[0] + 1;
+            continue;
+        }
+        for (unsigned int i = n.offset; i < n.offset + n.count; i++) {
+            float t = RayTriangle(origin, direction, triangles[i]);
+            if (t >= 0 && t < distance) {
+                distance = t;
+                hit = true;
+            }
+        }
+    }
+    return hit;
+}
+
+bool CollisionTree::Save(string file, boost::uint64_t key) const {
+    ofstream out(file.c_str(), ios::binary);
+    if (!out.is_open()) {
+        logger.warning << "Can not write collision tree " << file << logger.end;
+        return false;
+    }
+    unsigned int header[3] = { VERSION,
+                               (unsigned int)nodes.size(),
+                               (unsigned int)triangles.size() };
+    out.write(MAGIC, sizeof(MAGIC));
+    out.write((const char*)&key, sizeof(key));
+    out.write((const char*)header, sizeof(header));
+    if (!nodes.empty()) {
+        out.write((const char*)&nodes[0], nodes.size() * sizeof(Node));
+        out.write((const char*)&triangles[0], triangles.size() * sizeof(Triangle));
+    }
+    return out.good();
+}
+
+bool CollisionTree::Load(string file, boost::uint64_t key) {
+    ifstream in(file.c_str(), ios::binary);
+    if (!in.is_open()) return false;
+    char magic[4];
+    boost::uint64_t fileKey = 0;
+    unsigned int header[3] = { 0, 0, 0 };
+    in.read(magic, sizeof(magic));
+    in.read((char*)&fileKey, sizeof(fileKey));
+    in.read((char*)header, sizeof(header));
+    if (!in ||
+        memcmp(magic, MAGIC, sizeof(MAGIC)) != 0 ||
+        header[0] != VERSION ||
+        fileKey != key)
+        return false;
+
+    // The arrays must fill the rest of the file exactly
+    std::streampos start = in.tellg();
+    in.seekg(0, ios::end);
+    boost::uint64_t rest = in.tellg() - start;
+    in.seekg(start);
+    if (rest != (boost::uint64_t)header[1] * sizeof(Node)
+        + (boost::uint64_t)header[2] * sizeof(Triangle)) {
+        logger.warning << "Collision tree " << file << " is damaged" << logger.end;
+        return false;
+    }
+    nodes.resize(header[1]);
+    triangles.resize(header[2]);
+    if (!nodes.empty())
+        in.read((char*)&nodes[0], nodes.size() * sizeof(Node));
+    if (!triangles.empty())
+        in.read((char*)&triangles[0], triangles.size() * sizeof(Triangle));
+    if (!in || !Validate()) {
+        logger.warning << "Collision tree " << file << " is damaged" << logger.end;
+        Clear();
+        return false;
+    }
+    return true;
+}
+
+// Every child follows its parent in the node array and every leaf
+// range lies in the triangle array, and the tree is shallow enough
+// for the traversal stack: a node at depth d has at most d right
+// children of its ancestors waiting next to its own two.
+bool CollisionTree::Validate() const {
+    vector<unsigned int> depth(nodes.size(), 0);
+    for (unsigned int i = 0; i < nodes.size(); i++) {
+        const Node& n = nodes[i];
+        if (depth[i] + 2 > STACK_SIZE) return false;
+        if (n.count != 0) {
+            if ((boost::uint64_t)n.offset + n.count > triangles.size())
+                return false;
+            continue;
+        }
+        if (i + 1 >= nodes.size() || n.offset <= i + 1 ||
+            n.offset >= nodes.size())
+            return false;
+        // a damaged tree may share children, keep the deepest path
+        depth[i + 1] = std::max(depth[i + 1], depth[i] + 1);
+        depth[n.offset] = std::max(depth[n.offset], depth[i] + 1);
+    }
+    return true;
+}
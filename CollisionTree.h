@@ -0,0 +1,83 @@
+// Flattened bounding volume hierarchy of collision triangles.
+// -------------------------------------------------------------------
+// Copyright (C) 2007 OpenEngine.dk (See AUTHORS)
+//
+// This program is free software; It is covered by the GNU General
+// Public License version 2 or any later version.
+// See the GNU General Public License for more details (see LICENSE).
+//--------------------------------------------------------------------
+
+#ifndef _COLLISION_TREE_
+#define _COLLISION_TREE_
+
+#include <Scene/ISceneNode.h>
+
+#include <boost/cstdint.hpp>
+#include <string>
+#include <vector>
+
+using OpenEngine::Scene::ISceneNode;
+using std::string;
+using std::vector;
+
+/**
+ * Bounding volume hierarchy over the triangles of a scene, stored in
+ * two contiguous arrays.
+ *
+ * The nodes are laid out depth first, so the left child of an inner
+ * node directly follows it and only the right child index is stored.
+ * A node is 32 bytes. The triangles are reordered so that those of a
+ * leaf are consecutive, and a leaf only stores their range, so a
+ * query touches the node array and then reads the triangles of the
+ * leaves it reaches straight through.
+ *
+ * The tree is built top down, splitting the triangles at the median
+ * of their centers along the longest axis, and serializes to a flat
+ * binary file keyed like the physics cache. The key must cover the
+ * leaf size. A loaded tree is checked to only refer to its own nodes
+ * and triangles and to fit the traversal stack before it is used.
+ */
+class CollisionTree {
+public:
+    struct Node {
+        float min[3], max[3];
+        unsigned int offset;  // right child, or first triangle of a leaf
+        unsigned int count;   // triangles of a leaf, 0 for inner nodes
+    };
+
+    struct Triangle {
+        float v[3][3];
+    };
+
+private:
+    static const unsigned int VERSION = 1;
+
+    vector<Node> nodes;
+    vector<Triangle> triangles;
+    unsigned int leafSize;
+
+    unsigned int Build(unsigned int first, unsigned int count,
+                       vector<float>& centers);
+    bool Validate() const;
+
+public:
+    CollisionTree(unsigned int leafSize = 8);
+
+    void Build(ISceneNode& scene);
+    void Clear();
+
+    unsigned int GetLeafSize() const;
+    unsigned int GetNodeCount() const;
+    unsigned int GetTriangleCount() const;
+    unsigned long GetMemory() const;
+
+    unsigned int QueryBox(const float min[3], const float max[3],
+                          vector<unsigned int>* hits = NULL) const;
+    bool RayCast(const float origin[3], const float direction[3],
+                 float& distance) const;
+
+    bool Save(string file, boost::uint64_t key) const;
+    bool Load(string file, boost::uint64_t key);
+};
+
+#endif
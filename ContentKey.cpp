@@ -0,0 +1,51 @@
+#include "ContentKey.h"
+
+#include <Resources/DirectoryManager.h>
+#include <Logging/Logger.h>
+
+#include <fstream>
+
+using OpenEngine::Resources::DirectoryManager;
+using std::ifstream;
+using std::ios;
+
+namespace {
+const boost::uint64_t FNV_OFFSET = 14695981039346656037ULL;
+const boost::uint64_t FNV_PRIME  = 1099511628211ULL;
+}
+
+ContentKey::ContentKey()
+    : key(FNV_OFFSET)
+{}
+
+void ContentKey::AddBytes(const char* data, unsigned int size) {
+    for (unsigned int i = 0; i < size; i++) {
+        key ^= (unsigned char)data[i];
+        key *= FNV_PRIME;
+    }
+}
+
+void ContentKey::AddSource(string file) {
+    AddBytes(file.c_str(), file.size() + 1);
+
+    string path = DirectoryManager::FindFileInPath(file);
+    ifstream in(path.c_str(), ios::binary);
+    if (!in.is_open()) {
+        logger.warning << "Can not hash source file: " << file << logger.end;
+        return;
+    }
+    char buffer[65536];
+    while (in) {
+        in.read(buffer, sizeof(buffer));
+        AddBytes(buffer, in.gcount());
+    }
+}
+
+void ContentKey::AddParameter(string name, unsigned int value) {
+    AddBytes(name.c_str(), name.size() + 1);
+    AddBytes((const char*)&value, sizeof(value));
+}
+
+boost::uint64_t ContentKey::Get() const {
+    return key;
+}
@@ -0,0 +1,37 @@
+// Hash key over source files and build parameters.
+// -------------------------------------------------------------------
+// Copyright (C) 2007 OpenEngine.dk (See AUTHORS)
+//
+// This program is free software; It is covered by the GNU General
+// Public License version 2 or any later version.
+// See the GNU General Public License for more details (see LICENSE).
+//--------------------------------------------------------------------
+
+#ifndef _CONTENT_KEY_
+#define _CONTENT_KEY_
+
+#include <boost/cstdint.hpp>
+#include <string>
+
+using std::string;
+
+/**
+ * 64 bit FNV-1a hash of everything a cached build depends on: the
+ * names and contents of the source files and named parameters.
+ * Source files are looked up through the DirectoryManager.
+ */
+class ContentKey {
+private:
+    boost::uint64_t key;
+
+public:
+    ContentKey();
+
+    void AddBytes(const char* data, unsigned int size);
+    void AddSource(string file);
+    void AddParameter(string name, unsigned int value);
+
+    boost::uint64_t Get() const;
+};
+
+#endif
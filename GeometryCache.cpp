@@ -0,0 +1,97 @@
+#include "GeometryCache.h"
+
+#include <Geometry/Face.h>
+#include <Geometry/FaceSet.h>
+#include <Scene/GeometryNode.h>
+#include <Scene/SceneNode.h>
+#include <Scene/TransformationNode.h>
+
+#include <set>
+
+using OpenEngine::Geometry::Face;
+using OpenEngine::Geometry::FaceList;
+using OpenEngine::Geometry::FaceSet;
+using OpenEngine::Scene::GeometryNode;
+using OpenEngine::Scene::SceneNode;
+using OpenEngine::Scene::TransformationNode;
+using std::set;
+
+namespace {
+void CountFaces(ISceneNode* node, set<Face*>& unique, unsigned long& references) {
+    GeometryNode* geom = dynamic_cast<GeometryNode*>(node);
+    if (geom != NULL && geom->GetFaceSet() != NULL) {
+        FaceSet* fs = geom->GetFaceSet();
+        for (FaceList::iterator itr = fs->begin(); itr != fs->end(); itr++) {
+            unique.insert(itr->get());
+            references++;
+        }
+    }
+    for (unsigned int i = 0; i < node->GetNumberOfNodes(); i++)
+        CountFaces(node->GetNode(i), unique, references);
+}
+}
+
+GeometryCache::GeometryCache()
+    : shared(0)
+    , savedBytes(0)
+{}
+
+// Copies the node tree. Geometry nodes get a new face set with the
+// same faces, transformation nodes keep their transformation and any
+// other node becomes a plain scene node.
+ISceneNode* GeometryCache::Copy(ISceneNode* node, unsigned long& bytes) {
+    ISceneNode* copy;
+    GeometryNode* geom = dynamic_cast<GeometryNode*>(node);
+    TransformationNode* tran = dynamic_cast<TransformationNode*>(node);
+    if (geom != NULL) {
+        FaceSet* faces = new FaceSet();
+        if (geom->GetFaceSet() != NULL) {
+            faces->Add(geom->GetFaceSet());
+            bytes += faces->Size() * sizeof(Face);
+        }
+        copy = new GeometryNode(faces);
+    } else if (tran != NULL) {
+        TransformationNode* t = new TransformationNode();
+        t->SetPosition(tran->GetPosition());
+        t->SetRotation(tran->GetRotation());
+        copy = t;
+    } else
+        copy = new SceneNode();
+
+    for (unsigned int i = 0; i < node->GetNumberOfNodes(); i++)
+        copy->AddNode(Copy(node->GetNode(i), bytes));
+    return copy;
+}
+
+ISceneNode* GeometryCache::Share(ISceneNode* node) {
+    if (node == NULL) return NULL;
+    unsigned long bytes = 0;
+    ISceneNode* copy = Copy(node, bytes);
+    lock.Lock();
+    shared++;
+    savedBytes += bytes;
+    lock.Unlock();
+    return copy;
+}
+
+unsigned int GeometryCache::GetSharedCount() const {
+    return shared;
+}
+
+unsigned long GeometryCache::GetSavedBytes() const {
+    return savedBytes;
+}
+
+// Bytes of the distinct faces held by the scenes. If referenced is
+// given it receives the bytes the faces would take without sharing.
+unsigned long GeometryCache::GetFaceBytes(ISceneNode** scenes, unsigned int count,
+                                          unsigned long* referenced) {
+    set<Face*> unique;
+    unsigned long references = 0;
+    for (unsigned int i = 0; i < count; i++)
+        if (scenes[i] != NULL)
+            CountFaces(scenes[i], unique, references);
+    if (referenced != NULL)
+        *referenced = references * sizeof(Face);
+    return unique.size() * sizeof(Face);
+}
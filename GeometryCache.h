@@ -0,0 +1,56 @@
+// Shared geometry of models loaded more than once.
+// -------------------------------------------------------------------
+// Copyright (C) 2007 OpenEngine.dk (See AUTHORS)
+//
+// This program is free software; It is covered by the GNU General
+// Public License version 2 or any later version.
+// See the GNU General Public License for more details (see LICENSE).
+//--------------------------------------------------------------------
+
+#ifndef _GEOMETRY_CACHE_
+#define _GEOMETRY_CACHE_
+
+#include <Core/Mutex.h>
+#include <Scene/ISceneNode.h>
+
+#include <string>
+
+using OpenEngine::Core::Mutex;
+using OpenEngine::Scene::ISceneNode;
+using std::string;
+
+/**
+ * Hands out copies of a loaded model that share its faces.
+ *
+ * A model listed more than once in the manifest is parsed once. Every
+ * further entry gets its own node tree, as a node can only have one
+ * parent, but the geometry nodes of the copies hold the very same
+ * faces. The faces are reference counted and never changed in place
+ * after loading: the scene transformers split faces into new ones
+ * and build new face sets, so a scene that transforms its copy
+ * leaves the other copies untouched.
+ *
+ * The cache counts the bytes of face data that sharing saved, and
+ * can measure how much face data a set of scenes holds.
+ */
+class GeometryCache {
+private:
+    unsigned int shared;
+    unsigned long savedBytes;
+    Mutex lock;
+
+    ISceneNode* Copy(ISceneNode* node, unsigned long& bytes);
+
+public:
+    GeometryCache();
+
+    ISceneNode* Share(ISceneNode* node);
+
+    unsigned int GetSharedCount() const;
+    unsigned long GetSavedBytes() const;
+
+    static unsigned long GetFaceBytes(ISceneNode** scenes, unsigned int count,
+                                      unsigned long* referenced = NULL);
+};
+
+#endif
@@ -0,0 +1,164 @@
+#include "HUDPanel.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+const char* FONT_FACE = "Sans";
+
+void SelectFont(cairo_t* cr, double size) {
+    cairo_select_font_face(cr, FONT_FACE,
+                           CAIRO_FONT_SLANT_NORMAL,
+                           CAIRO_FONT_WEIGHT_BOLD);
+    cairo_set_font_size(cr, size);
+}
+}
+
+HUDPanel::HUDPanel(cairo_surface_t* surface,
+                   double fontSize,
+                   unsigned int refreshInterval)
+    : surface(surface)
+    , fontSize(fontSize)
+    , refreshInterval(refreshInterval)
+    , refreshes(0)
+{
+    cairo_t* cr = cairo_create(surface);
+    SelectFont(cr, fontSize);
+    cairo_font_extents_t fe;
+    cairo_font_extents(cr, &fe);
+    cairo_destroy(cr);
+    ascent = (int)ceil(fe.ascent);
+    lineHeight = (int)ceil(fe.ascent + fe.descent);
+}
+
+HUDPanel::~HUDPanel() {
+    map<char, Glyph>::iterator itr;
+    for (itr = glyphs.begin(); itr != glyphs.end(); itr++)
+        cairo_surface_destroy(itr->second.surface);
+}
+
+unsigned int HUDPanel::AddWidget(int x, int y, int width, int height) {
+    Widget w;
+    w.x = x; w.y = y;
+    w.width = width; w.height = height;
+    w.dirty = true;
+    widgets.push_back(w);
+    return widgets.size() - 1;
+}
+
+void HUDPanel::SetText(unsigned int widget, string text) {
+    Widget& w = widgets[widget];
+    if (w.text == text) return;
+    w.text = text;
+    w.dirty = true;
+}
+
+void HUDPanel::SetRefreshInterval(unsigned int usec) {
+    refreshInterval = usec;
+}
+
+unsigned int HUDPanel::GetRefreshInterval() const {
+    return refreshInterval;
+}
+
+unsigned int HUDPanel::GetRefreshCount() const {
+    return refreshes;
+}
+
+unsigned int HUDPanel::GetGlyphCount() const {
+    return glyphs.size();
+}
+
+const HUDPanel::Glyph& HUDPanel::GetGlyph(char c) {
+    map<char, Glyph>::iterator itr = glyphs.find(c);
+    if (itr != glyphs.end()) return itr->second;
+
+    char str[2] = { c, 0 };
+    cairo_t* cr = cairo_create(surface);
+    SelectFont(cr, fontSize);
+    cairo_text_extents_t te;
+    cairo_text_extents(cr, str, &te);
+    cairo_destroy(cr);
+
+    Glyph g;
+    g.width = std::max(1, (int)ceil(te.x_advance));
+    g.surface = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, g.width, lineHeight);
+    cr = cairo_create(g.surface);
+    SelectFont(cr, fontSize);
+    cairo_set_source_rgba(cr, 1, 1, 1, 1);
+    cairo_move_to(cr, 0, ascent);
+    cairo_show_text(cr, str);
+    cairo_destroy(cr);
+    cairo_surface_flush(g.surface);
+
+    return glyphs[c] = g;
+}
+
+void HUDPanel::PaintWidget(cairo_t* cr, Widget& w) {
+    cairo_save(cr);
+    cairo_rectangle(cr, w.x, w.y, w.width, w.height);
+    cairo_set_operator(cr, CAIRO_OPERATOR_CLEAR);
+    cairo_fill(cr);
+    cairo_set_operator(cr, CAIRO_OPERATOR_OVER);
+
+    int x = w.x;
+    for (unsigned int i = 0; i < w.text.size(); i++) {
+        const Glyph& g = GetGlyph(w.text[i]);
+        int width = std::min(g.width, w.x + w.width - x);
+        if (width <= 0) break;
+        cairo_set_source_surface(cr, g.surface, x, w.y);
+        cairo_rectangle(cr, x, w.y, width, std::min(lineHeight, w.height));
+        cairo_fill(cr);
+        x += g.width;
+    }
+    cairo_restore(cr);
+    w.dirty = false;
+}
+
+bool HUDPanel::Refresh() {
+    int x0 = 0, y0 = 0, x1 = 0, y1 = 0;
+    bool changed = false;
+    cairo_t* cr = NULL;
+    for (unsigned int i = 0; i < widgets.size(); i++) {
+        Widget& w = widgets[i];
+        if (!w.dirty) continue;
+        if (cr == NULL) cr = cairo_create(surface);
+        PaintWidget(cr, w);
+        if (!changed) {
+            x0 = w.x; y0 = w.y;
+            x1 = w.x + w.width; y1 = w.y + w.height;
+            changed = true;
+        } else {
+            x0 = std::min(x0, w.x);
+            y0 = std::min(y0, w.y);
+            x1 = std::max(x1, w.x + w.width);
+            y1 = std::max(y1, w.y + w.height);
+        }
+    }
+    if (!changed) return false;
+    cairo_destroy(cr);
+    cairo_surface_flush(surface);
+    refreshes++;
+
+    HUDRegionEventArg arg;
+    arg.x = x0; arg.y = y0;
+    arg.width = x1 - x0; arg.height = y1 - y0;
+    regionChangedEvent.Notify(arg);
+    return true;
+}
+
+IEvent<HUDRegionEventArg>& HUDPanel::RegionChangedEvent() {
+    return regionChangedEvent;
+}
+
+void HUDPanel::Handle(InitializeEventArg arg) {
+    timer.Start();
+}
+
+void HUDPanel::Handle(ProcessEventArg arg) {
+    if (timer.GetElapsedTime().AsInt() < refreshInterval) return;
+    timer.Reset();
+    Refresh();
+}
+
+void HUDPanel::Handle(DeinitializeEventArg arg) {}
@@ -0,0 +1,102 @@
+// Head-up display panel with dirty region updates.
+// -------------------------------------------------------------------
+// Copyright (C) 2007 OpenEngine.dk (See AUTHORS)
+//
+// This program is free software; It is covered by the GNU General
+// Public License version 2 or any later version.
+// See the GNU General Public License for more details (see LICENSE).
+//--------------------------------------------------------------------
+
+#ifndef _HUD_PANEL_
+#define _HUD_PANEL_
+
+#include <Core/IModule.h>
+#include <Core/Event.h>
+#include <Utils/Timer.h>
+
+#include <cairo.h>
+#include <map>
+#include <string>
+#include <vector>
+
+using OpenEngine::Core::IModule;
+using OpenEngine::Core::IEvent;
+using OpenEngine::Core::Event;
+using OpenEngine::Core::InitializeEventArg;
+using OpenEngine::Core::ProcessEventArg;
+using OpenEngine::Core::DeinitializeEventArg;
+using OpenEngine::Utils::Timer;
+using std::map;
+using std::string;
+using std::vector;
+
+/**
+ * Region of the HUD surface that has been repainted.
+ */
+struct HUDRegionEventArg {
+    int x, y, width, height;
+};
+
+/**
+ * Text widgets drawn onto a cairo image surface.
+ *
+ * Setting the text of a widget only marks it dirty if the text
+ * changed. Dirty widgets are repainted on the next refresh, which
+ * happens at most once per refresh interval, independent of the
+ * frame rate. A refresh notifies the region changed event with the
+ * bounding rectangle of the repainted widgets, so only that part of
+ * the surface has to be uploaded.
+ *
+ * Glyphs are rasterized once into small surfaces and then composed
+ * into the widgets, so repainting numbers costs a few blits.
+ */
+class HUDPanel : public IModule {
+private:
+    struct Widget {
+        int x, y, width, height;
+        string text;
+        bool dirty;
+    };
+
+    struct Glyph {
+        cairo_surface_t* surface;
+        int width;
+    };
+
+    cairo_surface_t* surface;
+    double fontSize;
+    int ascent, lineHeight;
+    vector<Widget> widgets;
+    map<char, Glyph> glyphs;
+    unsigned int refreshInterval;
+    unsigned int refreshes;
+    Timer timer;
+    Event<HUDRegionEventArg> regionChangedEvent;
+
+    const Glyph& GetGlyph(char c);
+    void PaintWidget(cairo_t* cr, Widget& w);
+
+public:
+    HUDPanel(cairo_surface_t* surface,
+             double fontSize = 14.0,
+             unsigned int refreshInterval = 100000);
+    virtual ~HUDPanel();
+
+    unsigned int AddWidget(int x, int y, int width, int height);
+    void SetText(unsigned int widget, string text);
+
+    void SetRefreshInterval(unsigned int usec);
+    unsigned int GetRefreshInterval() const;
+    unsigned int GetRefreshCount() const;
+    unsigned int GetGlyphCount() const;
+
+    bool Refresh();
+
+    IEvent<HUDRegionEventArg>& RegionChangedEvent();
+
+    void Handle(InitializeEventArg arg);
+    void Handle(ProcessEventArg arg);
+    void Handle(DeinitializeEventArg arg);
+};
+
+#endif
@@ -0,0 +1,43 @@
+#include "HUDStatistics.h"
+
+#include <sstream>
+
+HUDStatistics::HUDStatistics(HUDPanel& panel, TransformationNode* vehicle,
+                             unsigned int interval)
+    : panel(panel)
+    , vehicle(vehicle)
+    , interval(interval)
+    , frames(0)
+{
+    fpsWidget   = panel.AddWidget(8,   4, 200, 20);
+    speedWidget = panel.AddWidget(220, 4, 200, 20);
+}
+
+void HUDStatistics::Handle(InitializeEventArg arg) {
+    frames = 0;
+    if (vehicle != NULL) lastCenter = vehicle->GetPosition();
+    timer.Start();
+}
+
+void HUDStatistics::Handle(ProcessEventArg arg) {
+    frames++;
+    unsigned int elapsed = timer.GetElapsedTime().AsInt();
+    if (elapsed < interval) return;
+    timer.Reset();
+
+    std::ostringstream fps;
+    fps << "FPS: " << (unsigned int)(frames * 1000000.0f / elapsed);
+    panel.SetText(fpsWidget, fps.str());
+    frames = 0;
+
+    if (vehicle != NULL) {
+        Vector<3,float> center = vehicle->GetPosition();
+        float speed = (center - lastCenter).GetLength() * 1000000.0f / elapsed;
+        lastCenter = center;
+        std::ostringstream spd;
+        spd << "Speed: " << (unsigned int)speed;
+        panel.SetText(speedWidget, spd.str());
+    }
+}
+
+void HUDStatistics::Handle(DeinitializeEventArg arg) {}
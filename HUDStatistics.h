@@ -0,0 +1,47 @@
+// Statistics widgets for the head-up display.
+// -------------------------------------------------------------------
+// Copyright (C) 2007 OpenEngine.dk (See AUTHORS)
+//
+// This program is free software; It is covered by the GNU General
+// Public License version 2 or any later version.
+// See the GNU General Public License for more details (see LICENSE).
+//--------------------------------------------------------------------
+
+#ifndef _HUD_STATISTICS_
+#define _HUD_STATISTICS_
+
+#include <Core/IModule.h>
+#include <Scene/TransformationNode.h>
+#include <Utils/Timer.h>
+
+#include "HUDPanel.h"
+
+using OpenEngine::Scene::TransformationNode;
+
+/**
+ * Feeds the frame rate and the vehicle speed into HUD panel widgets.
+ * The speed is taken from the vehicle's transformation node, which is
+ * owned by the render thread even when the physics has its own.
+ * The values are sampled once per interval; the panel only repaints
+ * the widgets whose text actually changed.
+ */
+class HUDStatistics : public IModule {
+private:
+    HUDPanel& panel;
+    TransformationNode* vehicle;
+    unsigned int interval;
+    unsigned int fpsWidget, speedWidget;
+    unsigned int frames;
+    Vector<3,float> lastCenter;
+    Timer timer;
+
+public:
+    HUDStatistics(HUDPanel& panel, TransformationNode* vehicle,
+                  unsigned int interval = 1000000);
+
+    void Handle(InitializeEventArg arg);
+    void Handle(ProcessEventArg arg);
+    void Handle(DeinitializeEventArg arg);
+};
+
+#endif
@@ -0,0 +1,32 @@
+#include <Meta/OpenGL.h>
+
+#include "HUDTextureUploader.h"
+
+HUDTextureUploader::HUDTextureUploader(ITextureResourcePtr texture,
+                                       cairo_surface_t* surface)
+    : texture(texture)
+    , surface(surface)
+    , uploadedBytes(0)
+{}
+
+void HUDTextureUploader::Handle(HUDRegionEventArg arg) {
+    if (texture->GetID() == 0) return;
+
+    // cairo ARGB32 is BGRA in memory on little endian machines
+    int stride = cairo_image_surface_get_stride(surface);
+    unsigned char* data = cairo_image_surface_get_data(surface)
+        + arg.y * stride + arg.x * 4;
+
+    glBindTexture(GL_TEXTURE_2D, texture->GetID());
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, stride / 4);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, arg.x, arg.y, arg.width, arg.height,
+                    GL_BGRA, GL_UNSIGNED_BYTE, data);
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    uploadedBytes += arg.width * arg.height * 4;
+}
+
+unsigned long long HUDTextureUploader::GetUploadedBytes() const {
+    return uploadedBytes;
+}
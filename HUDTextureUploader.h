@@ -0,0 +1,41 @@
+// Sub-region texture upload of the head-up display.
+// -------------------------------------------------------------------
+// Copyright (C) 2007 OpenEngine.dk (See AUTHORS)
+//
+// This program is free software; It is covered by the GNU General
+// Public License version 2 or any later version.
+// See the GNU General Public License for more details (see LICENSE).
+//--------------------------------------------------------------------
+
+#ifndef _HUD_TEXTURE_UPLOADER_
+#define _HUD_TEXTURE_UPLOADER_
+
+#include <Core/IListener.h>
+#include <Resources/ITextureResource.h>
+
+#include "HUDPanel.h"
+
+using OpenEngine::Core::IListener;
+using OpenEngine::Resources::ITextureResourcePtr;
+
+/**
+ * Uploads repainted HUD regions into the texture of the HUD layer
+ * with glTexSubImage2D. The texture must have been created by the
+ * texture loader, regions changed before that are skipped as the
+ * first upload takes the whole surface anyway.
+ */
+class HUDTextureUploader : public IListener<HUDRegionEventArg> {
+private:
+    ITextureResourcePtr texture;
+    cairo_surface_t* surface;
+    unsigned long long uploadedBytes;
+
+public:
+    HUDTextureUploader(ITextureResourcePtr texture,
+                       cairo_surface_t* surface);
+
+    void Handle(HUDRegionEventArg arg);
+    unsigned long long GetUploadedBytes() const;
+};
+
+#endif
@@ -0,0 +1,54 @@
+#include "HeadlessRunner.h"
+
+#include <Logging/Logger.h>
+
+HeadlessRunner::HeadlessRunner(IEngine& engine,
+                               unsigned int maxTicks,
+                               unsigned int reportInterval)
+    : engine(engine)
+    , maxTicks(maxTicks)
+    , reportInterval(reportInterval)
+    , ticks(0)
+    , intervalTicks(0)
+{}
+
+void HeadlessRunner::Handle(InitializeEventArg arg) {
+    ticks = intervalTicks = 0;
+    timer.Reset();
+    timer.Start();
+    intervalTimer.Reset();
+    intervalTimer.Start();
+}
+
+void HeadlessRunner::Handle(ProcessEventArg arg) {
+    ++ticks;
+    ++intervalTicks;
+
+    unsigned int elapsed = intervalTimer.GetElapsedTime().AsInt();
+    if (elapsed >= reportInterval) {
+        logger.info << "Headless: "
+                    << (intervalTicks * 1000000.0f / elapsed)
+                    << " ticks/s" << logger.end;
+        intervalTicks = 0;
+        intervalTimer.Reset();
+    }
+
+    if (maxTicks != 0 && ticks >= maxTicks)
+        engine.Stop();
+}
+
+void HeadlessRunner::Handle(DeinitializeEventArg arg) {
+    logger.info << "Headless: " << ticks << " ticks in "
+                << timer.GetElapsedTime().AsInt() / 1000 << " ms ("
+                << GetTicksPerSecond() << " ticks/s)" << logger.end;
+}
+
+unsigned int HeadlessRunner::GetTicks() const {
+    return ticks;
+}
+
+float HeadlessRunner::GetTicksPerSecond() {
+    unsigned int elapsed = timer.GetElapsedTime().AsInt();
+    if (elapsed == 0) return 0.0f;
+    return ticks * 1000000.0f / elapsed;
+}
@@ -0,0 +1,53 @@
+// Headless simulation runner.
+// -------------------------------------------------------------------
+// Copyright (C) 2007 OpenEngine.dk (See AUTHORS)
+//
+// This program is free software; It is covered by the GNU General
+// Public License version 2 or any later version.
+// See the GNU General Public License for more details (see LICENSE).
+//--------------------------------------------------------------------
+
+#ifndef _HEADLESS_RUNNER_
+#define _HEADLESS_RUNNER_
+
+#include <Core/IModule.h>
+#include <Core/IEngine.h>
+#include <Utils/Timer.h>
+
+using OpenEngine::Core::IModule;
+using OpenEngine::Core::IEngine;
+using OpenEngine::Core::InitializeEventArg;
+using OpenEngine::Core::ProcessEventArg;
+using OpenEngine::Core::DeinitializeEventArg;
+using OpenEngine::Utils::Timer;
+
+/**
+ * Drives the engine when no frame or renderer is attached.
+ *
+ * Counts the engine ticks (process events), logs the achieved tick
+ * rate once per report interval and stops the engine after a given
+ * number of ticks. A tick limit of zero runs until the engine is
+ * stopped by some other module.
+ */
+class HeadlessRunner : public IModule {
+private:
+    IEngine& engine;
+    unsigned int maxTicks;
+    unsigned int reportInterval;
+    unsigned int ticks, intervalTicks;
+    Timer timer, intervalTimer;
+
+public:
+    HeadlessRunner(IEngine& engine,
+                   unsigned int maxTicks = 0,
+                   unsigned int reportInterval = 1000000);
+
+    void Handle(InitializeEventArg arg);
+    void Handle(ProcessEventArg arg);
+    void Handle(DeinitializeEventArg arg);
+
+    unsigned int GetTicks() const;
+    float GetTicksPerSecond();
+};
+
+#endif
@@ -0,0 +1,80 @@
+#include <Meta/OpenGL.h>
+
+#include "IndexedBatchNode.h"
+
+using OpenEngine::Resources::ITextureResourcePtr;
+
+namespace {
+
+void SetMaterial(GLenum name, const Vector<4,float>& color) {
+    float c[4] = { color[0], color[1], color[2], color[3] };
+    glMaterialfv(GL_FRONT_AND_BACK, name, c);
+}
+
+} // anonymous namespace
+
+// The arrays are taken over, leaving the arguments empty
+IndexedBatchNode::IndexedBatchNode(MaterialPtr mat,
+                                   vector<float>& vertices,
+                                   vector<unsigned int>& indices)
+    : mat(mat)
+{
+    this->vertices.swap(vertices);
+    this->indices.swap(indices);
+}
+
+// Returns the texture id, 0 for none
+unsigned int IndexedBatchNode::BindTexture() {
+    if (!mat || !mat->texr) return 0;
+    ITextureResourcePtr texr = mat->texr;
+    if (texr->GetID() == 0) {
+        texr->Load();
+        GLenum format = GL_RGBA;
+        if (texr->GetDepth() == 24) format = GL_RGB;
+        else if (texr->GetDepth() == 8) format = GL_LUMINANCE;
+        GLuint id;
+        glGenTextures(1, &id);
+        glBindTexture(GL_TEXTURE_2D, id);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        glTexImage2D(GL_TEXTURE_2D, 0, format, texr->GetWidth(), texr->GetHeight(),
+                     0, format, GL_UNSIGNED_BYTE, texr->GetData());
+        texr->SetID(id);
+        texr->Unload();
+    }
+    glBindTexture(GL_TEXTURE_2D, texr->GetID());
+    return texr->GetID();
+}
+
+void IndexedBatchNode::Apply(IRenderingView* view) {
+    if (indices.empty()) return;
+    glPushAttrib(GL_LIGHTING_BIT | GL_TEXTURE_BIT | GL_CURRENT_BIT);
+    glPushClientAttrib(GL_CLIENT_VERTEX_ARRAY_BIT);
+
+    if (mat) {
+        SetMaterial(GL_DIFFUSE, mat->diffuse);
+        SetMaterial(GL_AMBIENT, mat->ambient);
+        SetMaterial(GL_SPECULAR, mat->specular);
+        SetMaterial(GL_EMISSION, mat->emission);
+        glMaterialf(GL_FRONT_AND_BACK, GL_SHININESS, mat->shininess);
+    }
+    if (BindTexture() != 0)
+        glEnable(GL_TEXTURE_2D);
+    else
+        glDisable(GL_TEXTURE_2D);
+
+    glInterleavedArrays(GL_T2F_C4F_N3F_V3F, 0, &vertices[0]);
+    glDrawElements(GL_TRIANGLES, indices.size(), GL_UNSIGNED_INT, &indices[0]);
+
+    glPopClientAttrib();
+    glPopAttrib();
+}
+
+unsigned int IndexedBatchNode::GetVertexCount() const {
+    return vertices.size() / VERTEX_SIZE;
+}
+
+unsigned int IndexedBatchNode::GetTriangleCount() const {
+    return indices.size() / 3;
+}
@@ -0,0 +1,58 @@
+// Indexed triangle batch drawn with a single call.
+// -------------------------------------------------------------------
+// Copyright (C) 2007 OpenEngine.dk (See AUTHORS)
+//
+// This program is free software; It is covered by the GNU General
+// Public License version 2 or any later version.
+// See the GNU General Public License for more details (see LICENSE).
+//--------------------------------------------------------------------
+
+#ifndef _INDEXED_BATCH_NODE_
+#define _INDEXED_BATCH_NODE_
+
+#include <Geometry/Material.h>
+#include <Renderers/IRenderNode.h>
+
+#include <vector>
+
+using OpenEngine::Geometry::MaterialPtr;
+using OpenEngine::Renderers::IRenderNode;
+using OpenEngine::Renderers::IRenderingView;
+using std::vector;
+
+/**
+ * Triangles of one material in an interleaved vertex array and an
+ * index array, drawn with glDrawElements.
+ *
+ * Each vertex is VERTEX_SIZE floats in the GL_T2F_C4F_N3F_V3F layout:
+ * texture coordinate, color, normal and position. The triangles are
+ * drawn in the order of the indices, so an order made for the
+ * post-transform vertex cache is kept.
+ *
+ * The texture loader only finds the textures of geometry nodes, so
+ * a texture without an id is uploaded by the node when it is first
+ * drawn.
+ */
+class IndexedBatchNode : public IRenderNode {
+public:
+    static const unsigned int VERTEX_SIZE = 12;
+
+private:
+    MaterialPtr mat;
+    vector<float> vertices;
+    vector<unsigned int> indices;
+
+    unsigned int BindTexture();
+
+public:
+    IndexedBatchNode(MaterialPtr mat,
+                     vector<float>& vertices,
+                     vector<unsigned int>& indices);
+
+    void Apply(IRenderingView* view);
+
+    unsigned int GetVertexCount() const;
+    unsigned int GetTriangleCount() const;
+};
+
+#endif
@@ -0,0 +1,111 @@
+#include "InputQueue.h"
+
+#include <Devices/Symbols.h>
+#include <Logging/Logger.h>
+
+namespace keys = OpenEngine::Devices;
+
+InputQueue::InputQueue()
+    : last(0)
+    , hasNext(false)
+    , events(0)
+    , latency(0)
+    , maxLatency(0)
+    , dropped(0)
+{
+    for (unsigned int c = 0; c < CONTROLS; c++)
+        values[c] = 0;
+    timer.Start();
+}
+
+unsigned int InputQueue::GetClock() {
+    return timer.GetElapsedTime().AsInt();
+}
+
+void InputQueue::Push(unsigned int control, float value, unsigned int time) {
+    InputEvent e;
+    e.time = time;
+    e.control = control;
+    e.value = value;
+    if (!queue.Push(e)) dropped++;
+}
+
+void InputQueue::Handle(KeyboardEventArg arg) {
+    float value = arg.type == KeyboardEventArg::PRESS ? 1 : 0;
+    unsigned int time = GetClock();
+    switch (arg.sym) {
+    case keys::KEY_UP:    Push(UP,    value, time); break;
+    case keys::KEY_DOWN:  Push(DOWN,  value, time); break;
+    case keys::KEY_LEFT:  Push(LEFT,  value, time); break;
+    case keys::KEY_RIGHT: Push(RIGHT, value, time); break;
+    default: break;
+    }
+}
+
+// Same mapping as the KeyboardHandler
+void InputQueue::Handle(JoystickAxisEventArg arg) {
+    float max = 1 << 15;
+    unsigned int time = GetClock();
+    Push(UP,    -arg.state.axisState[1] / max, time);
+    Push(DOWN,   arg.state.axisState[1] / max, time);
+    Push(LEFT,  -arg.state.axisState[0] / max, time);
+    Push(RIGHT,  arg.state.axisState[0] / max, time);
+}
+
+void InputQueue::Handle(DeinitializeEventArg arg) {
+    logger.info << "Input: " << events << " control events, "
+                << GetAverageLatency() / 1000 << " ms average and "
+                << maxLatency / 1000.0f << " ms max latency to the physics, "
+                << dropped << " dropped" << logger.end;
+}
+
+// Takes the events up to the time until off the queue and sets the
+// controls to their average since the previous call. Must only be
+// called from one thread.
+void InputQueue::Coalesce(unsigned int until, ControlState& controls) {
+    float sums[CONTROLS] = { 0, 0, 0, 0 };
+    unsigned int now = GetClock();
+    unsigned int t = last;
+    for (;;) {
+        if (!hasNext) hasNext = queue.Pop(next);
+        if (!hasNext || next.time > until) break;
+        hasNext = false;
+
+        unsigned int at = next.time > t ? next.time : t;
+        for (unsigned int c = 0; c < CONTROLS; c++)
+            sums[c] += values[c] * (at - t);
+        t = at;
+        values[next.control] = next.value;
+
+        unsigned int l = now > next.time ? now - next.time : 0;
+        latency += l;
+        if (l > maxLatency) maxLatency = l;
+        events++;
+    }
+
+    unsigned int end = until > t ? until : t;
+    for (unsigned int c = 0; c < CONTROLS; c++)
+        sums[c] += values[c] * (end - t);
+    float span = end - last;
+    float* out[CONTROLS] = { &controls.up, &controls.down,
+                             &controls.left, &controls.right };
+    for (unsigned int c = 0; c < CONTROLS; c++)
+        *out[c] = span > 0 ? sums[c] / span : values[c];
+    last = end;
+}
+
+unsigned int InputQueue::GetEventCount() const {
+    return events;
+}
+
+unsigned int InputQueue::GetDroppedCount() const {
+    return dropped;
+}
+
+float InputQueue::GetAverageLatency() const {
+    return events != 0 ? (float)latency / events : 0;
+}
+
+unsigned int InputQueue::GetMaxLatency() const {
+    return maxLatency;
+}
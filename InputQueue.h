@@ -0,0 +1,93 @@
+// Time stamped queue of the vehicle control input.
+// -------------------------------------------------------------------
+// Copyright (C) 2007 OpenEngine.dk (See AUTHORS)
+//
+// This program is free software; It is covered by the GNU General
+// Public License version 2 or any later version.
+// See the GNU General Public License for more details (see LICENSE).
+//--------------------------------------------------------------------
+
+#ifndef _INPUT_QUEUE_
+#define _INPUT_QUEUE_
+
+#include <Core/IListener.h>
+#include <Core/EngineEvents.h>
+#include <Devices/IKeyboard.h>
+#include <Devices/IJoystick.h>
+#include <Utils/Timer.h>
+
+#include "LockFree.h"
+
+using OpenEngine::Core::IListener;
+using OpenEngine::Core::DeinitializeEventArg;
+using OpenEngine::Devices::KeyboardEventArg;
+using OpenEngine::Devices::JoystickAxisEventArg;
+using OpenEngine::Utils::Timer;
+
+/**
+ * Control values of the vehicle over one physics step.
+ */
+struct ControlState {
+    float up, down, left, right;
+};
+
+/**
+ * Passes the vehicle controls from the input events to the physics
+ * steps.
+ *
+ * The arrow keys and the joystick axes are turned into control
+ * changes stamped with the time they arrived, and pushed on a lock
+ * free queue as they are delivered. The thread stepping the physics
+ * coalesces the queue once per step: every control is averaged over
+ * the time the step covers, weighted by how long each value was
+ * held, so a short tap or the intermediate axis samples still count
+ * instead of only the last value of a frame.
+ *
+ * The time from an event to the step that applies it is measured as
+ * the input latency and logged on deinitialize, with the number of
+ * events dropped because the queue was full.
+ */
+class InputQueue : public IListener<KeyboardEventArg>,
+                   public IListener<JoystickAxisEventArg>,
+                   public IListener<DeinitializeEventArg> {
+private:
+    enum Control { UP, DOWN, LEFT, RIGHT, CONTROLS };
+
+    struct InputEvent {
+        unsigned int time;
+        unsigned int control;
+        float value;
+    };
+
+    LockFreeQueue<InputEvent, 1024> queue;
+    Timer timer;
+    // consumer side
+    float values[CONTROLS];
+    unsigned int last;
+    InputEvent next;
+    bool hasNext;
+    unsigned int events;
+    unsigned long long latency;
+    unsigned int maxLatency;
+    // producer side
+    unsigned int dropped;
+
+    void Push(unsigned int control, float value, unsigned int time);
+
+public:
+    InputQueue();
+
+    void Handle(KeyboardEventArg arg);
+    void Handle(JoystickAxisEventArg arg);
+    void Handle(DeinitializeEventArg arg);
+
+    unsigned int GetClock();
+    void Coalesce(unsigned int until, ControlState& controls);
+
+    unsigned int GetEventCount() const;
+    unsigned int GetDroppedCount() const;
+    float GetAverageLatency() const;
+    unsigned int GetMaxLatency() const;
+};
+
+#endif
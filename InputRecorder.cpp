@@ -0,0 +1,73 @@
+#include "InputRecorder.h"
+
+#include <Logging/Logger.h>
+
+#include <fstream>
+
+using std::ofstream;
+using std::ios;
+
+InputRecorder::InputRecorder(string file)
+    : file(file)
+    , frame(0)
+    , records(0)
+{}
+
+void InputRecorder::Handle(InitializeEventArg arg) {
+    frame = 0;
+    records = 0;
+    log.clear();
+    log.reserve(1 << 20);
+    timer.Reset();
+    timer.Start();
+}
+
+void InputRecorder::Handle(ProcessEventArg arg) {
+    ++frame;
+}
+
+void InputRecorder::Handle(DeinitializeEventArg arg) {
+    Save();
+}
+
+void InputRecorder::Record(char type, const void* arg, unsigned int size) {
+    unsigned int time = timer.GetElapsedTime().AsInt();
+    log.push_back(type);
+    log.insert(log.end(), (const char*)&frame, (const char*)&frame + sizeof(frame));
+    log.insert(log.end(), (const char*)&time,  (const char*)&time  + sizeof(time));
+    log.insert(log.end(), (const char*)arg,    (const char*)arg    + size);
+    ++records;
+}
+
+void InputRecorder::Handle(KeyboardEventArg arg) {
+    Record(InputLog::KEYBOARD, &arg, sizeof(arg));
+}
+
+void InputRecorder::Handle(JoystickButtonEventArg arg) {
+    Record(InputLog::JOYSTICK_BUTTON, &arg, sizeof(arg));
+}
+
+void InputRecorder::Handle(JoystickAxisEventArg arg) {
+    Record(InputLog::JOYSTICK_AXIS, &arg, sizeof(arg));
+}
+
+bool InputRecorder::Save() {
+    ofstream out(file.c_str(), ios::binary);
+    if (!out.is_open()) {
+        logger.error << "Can not open '" << file << "' for output" << logger.end;
+        return false;
+    }
+    unsigned int version = InputLog::VERSION;
+    unsigned short sizes[3] = { sizeof(KeyboardEventArg),
+                                sizeof(JoystickButtonEventArg),
+                                sizeof(JoystickAxisEventArg) };
+    out.write(InputLog::MAGIC, sizeof(InputLog::MAGIC));
+    out.write((const char*)&version, sizeof(version));
+    out.write((const char*)sizes, sizeof(sizes));
+    out.write((const char*)&frame, sizeof(frame));
+    if (!log.empty())
+        out.write(&log[0], log.size());
+    logger.info << "Recorded " << records << " input events in "
+                << frame << " frames to '" << file << "'" << logger.end;
+    return out.good();
+}
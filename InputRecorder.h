@@ -0,0 +1,85 @@
+// Input event recorder.
+// -------------------------------------------------------------------
+// Copyright (C) 2007 OpenEngine.dk (See AUTHORS)
+//
+// This program is free software; It is covered by the GNU General
+// Public License version 2 or any later version.
+// See the GNU General Public License for more details (see LICENSE).
+//--------------------------------------------------------------------
+
+#ifndef _INPUT_RECORDER_
+#define _INPUT_RECORDER_
+
+#include <Core/IModule.h>
+#include <Devices/IKeyboard.h>
+#include <Devices/IJoystick.h>
+#include <Utils/Timer.h>
+
+#include <string>
+#include <vector>
+
+using OpenEngine::Core::IModule;
+using OpenEngine::Core::IListener;
+using OpenEngine::Core::InitializeEventArg;
+using OpenEngine::Core::ProcessEventArg;
+using OpenEngine::Core::DeinitializeEventArg;
+using OpenEngine::Devices::KeyboardEventArg;
+using OpenEngine::Devices::JoystickButtonEventArg;
+using OpenEngine::Devices::JoystickAxisEventArg;
+using OpenEngine::Utils::Timer;
+using std::string;
+using std::vector;
+
+/**
+ * Binary input log format shared by the recorder and the replay.
+ *
+ * The file starts with a header of the magic "OEIR", the format
+ * version, the sizes of the three event argument types and the
+ * number of recorded frames. Then follow the records: a one byte
+ * event type, the frame number, the time in microseconds since
+ * initialization and the raw event argument. The argument sizes in
+ * the header guard against replaying a log written by a build with
+ * different event structures.
+ */
+namespace InputLog {
+    enum Type { KEYBOARD = 1, JOYSTICK_BUTTON = 2, JOYSTICK_AXIS = 3 };
+    const char MAGIC[4] = { 'O', 'E', 'I', 'R' };
+    const unsigned int VERSION = 1;
+}
+
+/**
+ * Records keyboard and joystick events with their frame number and
+ * time stamp. The log is kept in memory and written to the file on
+ * deinitialize, so recording does no file I/O inside the frame.
+ *
+ * The recorder counts frames on the process event and must be
+ * attached before the input device so events of a frame get that
+ * frame's number.
+ */
+class InputRecorder : public IModule,
+                      public IListener<KeyboardEventArg>,
+                      public IListener<JoystickButtonEventArg>,
+                      public IListener<JoystickAxisEventArg> {
+private:
+    string file;
+    vector<char> log;
+    unsigned int frame;
+    unsigned int records;
+    Timer timer;
+
+    void Record(char type, const void* arg, unsigned int size);
+
+public:
+    InputRecorder(string file);
+
+    void Handle(InitializeEventArg arg);
+    void Handle(ProcessEventArg arg);
+    void Handle(DeinitializeEventArg arg);
+    void Handle(KeyboardEventArg arg);
+    void Handle(JoystickButtonEventArg arg);
+    void Handle(JoystickAxisEventArg arg);
+
+    bool Save();
+};
+
+#endif
@@ -0,0 +1,141 @@
+#include "InputReplay.h"
+
+#include <Core/Exceptions.h>
+#include <Logging/Logger.h>
+
+#include <cstring>
+#include <fstream>
+
+using OpenEngine::Core::Exception;
+using std::ifstream;
+using std::ios;
+
+namespace {
+unsigned int SizeOf(char type) {
+    switch (type) {
+    case InputLog::KEYBOARD:        return sizeof(KeyboardEventArg);
+    case InputLog::JOYSTICK_BUTTON: return sizeof(JoystickButtonEventArg);
+    case InputLog::JOYSTICK_AXIS:   return sizeof(JoystickAxisEventArg);
+    default: return 0;
+    }
+}
+}
+
+InputReplay::InputReplay(IEngine& engine, string file, bool stopAtEnd)
+    : engine(engine)
+    , file(file)
+    , stopAtEnd(stopAtEnd)
+    , frames(0)
+    , frame(0)
+    , next(0)
+{}
+
+bool InputReplay::Load() {
+    ifstream in(file.c_str(), ios::binary);
+    if (!in.is_open()) {
+        logger.error << "Can not open input log '" << file << "'" << logger.end;
+        return false;
+    }
+
+    char magic[4];
+    unsigned int version = 0;
+    unsigned short sizes[3] = { 0, 0, 0 };
+    in.read(magic, sizeof(magic));
+    in.read((char*)&version, sizeof(version));
+    in.read((char*)sizes, sizeof(sizes));
+    in.read((char*)&frames, sizeof(frames));
+    if (!in ||
+        memcmp(magic, InputLog::MAGIC, sizeof(magic)) != 0 ||
+        version != InputLog::VERSION ||
+        sizes[0] != sizeof(KeyboardEventArg) ||
+        sizes[1] != sizeof(JoystickButtonEventArg) ||
+        sizes[2] != sizeof(JoystickAxisEventArg)) {
+        logger.error << "Input log '" << file
+                     << "' was not written by this build" << logger.end;
+        return false;
+    }
+
+    records.clear();
+    data.clear();
+    for (;;) {
+        Record r;
+        in.read(&r.type, sizeof(r.type));
+        in.read((char*)&r.frame, sizeof(r.frame));
+        in.read((char*)&r.time, sizeof(r.time));
+        if (!in) break;
+        unsigned int size = SizeOf(r.type);
+        if (size == 0) {
+            logger.error << "Input log '" << file << "' is corrupt" << logger.end;
+            return false;
+        }
+        r.offset = data.size();
+        data.resize(data.size() + size);
+        in.read(&data[r.offset], size);
+        if (!in) break;
+        records.push_back(r);
+    }
+    logger.info << "Loaded " << records.size() << " input events from '"
+                << file << "'" << logger.end;
+    return true;
+}
+
+void InputReplay::Handle(InitializeEventArg arg) {
+    if (records.empty() && !Load())
+        throw Exception("Can not replay input log: " + file);
+    frame = 0;
+    next = 0;
+}
+
+void InputReplay::Handle(ProcessEventArg arg) {
+    ++frame;
+    while (next < records.size() && records[next].frame <= frame) {
+        const Record& r = records[next++];
+        const char* a = &data[r.offset];
+        switch (r.type) {
+        case InputLog::KEYBOARD: {
+            KeyboardEventArg e;
+            memcpy(&e, a, sizeof(e));
+            keyEvent.Notify(e);
+            break;
+        }
+        case InputLog::JOYSTICK_BUTTON: {
+            JoystickButtonEventArg e;
+            memcpy(&e, a, sizeof(e));
+            joystickButtonEvent.Notify(e);
+            break;
+        }
+        case InputLog::JOYSTICK_AXIS: {
+            JoystickAxisEventArg e;
+            memcpy(&e, a, sizeof(e));
+            joystickAxisEvent.Notify(e);
+            break;
+        }
+        }
+    }
+    if (stopAtEnd && IsDone()) {
+        logger.info << "Input replay finished at frame " << frame << logger.end;
+        engine.Stop();
+    }
+}
+
+void InputReplay::Handle(DeinitializeEventArg arg) {}
+
+IEvent<KeyboardEventArg>& InputReplay::KeyEvent() {
+    return keyEvent;
+}
+
+IEvent<JoystickButtonEventArg>& InputReplay::JoystickButtonEvent() {
+    return joystickButtonEvent;
+}
+
+IEvent<JoystickAxisEventArg>& InputReplay::JoystickAxisEvent() {
+    return joystickAxisEvent;
+}
+
+unsigned int InputReplay::GetRecordCount() const {
+    return records.size();
+}
+
+bool InputReplay::IsDone() const {
+    return next >= records.size() && frame >= frames;
+}
@@ -0,0 +1,70 @@
+// Input event replay.
+// -------------------------------------------------------------------
+// Copyright (C) 2007 OpenEngine.dk (See AUTHORS)
+//
+// This program is free software; It is covered by the GNU General
+// Public License version 2 or any later version.
+// See the GNU General Public License for more details (see LICENSE).
+//--------------------------------------------------------------------
+
+#ifndef _INPUT_REPLAY_
+#define _INPUT_REPLAY_
+
+#include <Core/IModule.h>
+#include <Core/IEngine.h>
+#include <Core/Event.h>
+
+#include "InputRecorder.h"
+
+using OpenEngine::Core::IEngine;
+using OpenEngine::Core::IEvent;
+using OpenEngine::Core::Event;
+
+/**
+ * Plays back an input log written by the InputRecorder.
+ *
+ * On every process event the replay advances one frame and notifies
+ * the events recorded for that frame, in recorded order, through the
+ * same events an input device offers. It should be attached to the
+ * process event where the input device would have been. When all
+ * recorded frames have been played the engine is stopped, if
+ * requested.
+ */
+class InputReplay : public IModule {
+private:
+    struct Record {
+        char type;
+        unsigned int frame;
+        unsigned int time;
+        unsigned int offset;   // of the event argument in data
+    };
+
+    IEngine& engine;
+    string file;
+    bool stopAtEnd;
+    vector<Record> records;
+    vector<char> data;
+    unsigned int frames;
+    unsigned int frame, next;
+    Event<KeyboardEventArg>       keyEvent;
+    Event<JoystickButtonEventArg> joystickButtonEvent;
+    Event<JoystickAxisEventArg>   joystickAxisEvent;
+
+public:
+    InputReplay(IEngine& engine, string file, bool stopAtEnd = true);
+
+    bool Load();
+
+    void Handle(InitializeEventArg arg);
+    void Handle(ProcessEventArg arg);
+    void Handle(DeinitializeEventArg arg);
+
+    IEvent<KeyboardEventArg>&       KeyEvent();
+    IEvent<JoystickButtonEventArg>& JoystickButtonEvent();
+    IEvent<JoystickAxisEventArg>&   JoystickAxisEvent();
+
+    unsigned int GetRecordCount() const;
+    bool IsDone() const;
+};
+
+#endif
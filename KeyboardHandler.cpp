@@ -11,53 +11,47 @@ KeyboardHandler::KeyboardHandler(IEngine& engine,
         , down(0)
         , left(0)
         , right(0)
+        , mod(0)
+        , step(0)
+        , stepFraction(0)
+        , fixedDelta(0)
         , camera(camera)
         , box(box)
         , physics(physics)
         , engine(engine)
+        , commands(NULL)
+        , scheduler(NULL)
+        , input(NULL)
+        , snapshots(NULL)
     {}
 
 
 void KeyboardHandler::Handle(InitializeEventArg arg) {
         step = 0.0f;
+        stepFraction = 0.0f;
         timer.Start();
     }
 void KeyboardHandler::Handle(DeinitializeEventArg arg) {}
 void KeyboardHandler::Handle(ProcessEventArg arg) {
 
-        float delta = (float) timer.GetElapsedTimeAndReset().AsInt() / 100000;
+        unsigned int elapsed = timer.GetElapsedTimeAndReset().AsInt();
+        float delta = (float) elapsed / 100000;
+        if (fixedDelta != 0) delta = fixedDelta;
+
+        // Holding plus or minus changes the physics step time by a
+        // millisecond per second. Frames are shorter than the step of a
+        // usec, so the fractions add up until a whole usec is reached.
+        if (mod && scheduler != NULL) {
+            stepFraction += step * elapsed;
+            int usec = (int)stepFraction;
+            stepFraction -= usec;
+            if (usec != 0) scheduler->AdjustStepTime(usec);
+        }
 
+        if (input != NULL) return;
         if (box == NULL || !( up || down || left || right )) return;
 
-        static float speed = 1750.0f;
-        static float turn = 550.0f;
-        Matrix<3,3,float> m(box->GetRotationMatrix());
-
-        // Forward 
-        if( up ){
-            Vector<3,float> dir = m.GetRow(0) * delta;
-            box->AddForce(dir * speed*up, 1);
-            box->AddForce(dir * speed*up, 2);
-            box->AddForce(dir * speed*up, 3);
-            box->AddForce(dir * speed*up, 4);
-        }
-        if( down ){
-            Vector<3,float> dir = -m.GetRow(0) * delta;
-            box->AddForce(dir * speed*down, 5);
-            box->AddForce(dir * speed*down, 6);
-            box->AddForce(dir * speed*down, 7);
-            box->AddForce(dir * speed*down, 8);
-        }
-        if( left ){
-            Vector<3,float> dir = -m.GetRow(2) * delta;
-            box->AddForce(dir * turn*left, 2);
-            box->AddForce(dir * turn*left, 4);
-        }
-        if( right ) {
-            Vector<3,float> dir = m.GetRow(2) * delta;
-            box->AddForce(dir * turn*right, 1);
-            box->AddForce(dir * turn*right, 3);
-        }
+        Send(PhysicsCommand::Controls(up, down, left, right, delta));
     }
 
 void KeyboardHandler::Handle(KeyboardEventArg arg) {
@@ -67,23 +61,20 @@ void KeyboardHandler::Handle(KeyboardEventArg arg) {
 void KeyboardHandler::KeyDown(KeyboardEventArg arg) {
         switch ( arg.sym ) {
         case keys::KEY_r: {
-            physics->Handle(InitializeEventArg());
-            if( physics != NULL ){
-                if( box != NULL ) {
-                    box->ResetForces();
-                    box->SetCenter( Vector<3,float>(2, 1, 2) );
-                    logger.info << "Reset Physics" << logger.end;
-                }
-            }
+            Send(PhysicsCommand::Reset());
             break;
         }
 
         case keys::KEY_SPACE:{
-            if( physics != NULL ){
-                physics->TogglePause();
-            }
+            Send(PhysicsCommand::Pause());
             break;
         }
+
+        // Rewind the physics 100 steps, a second at the default rate.
+        // The step rate can be changed, so it is not kept in seconds.
+        case keys::KEY_BACKSPACE:
+            Send(PhysicsCommand::Rewind(REWIND_STEPS));
+            break;
         // Move the car forward
         case keys::KEY_UP:    up    = 1; break;
         case keys::KEY_DOWN:  down  = 1; break;
@@ -116,8 +107,14 @@ void KeyboardHandler::KeyUp(KeyboardEventArg arg) {
         case keys::KEY_DOWN:  down  = 0; break;
         case keys::KEY_LEFT:  left  = 0; break;
         case keys::KEY_RIGHT: right = 0; break;
-        case keys::KEY_PLUS:  mod   = false; break;
-        case keys::KEY_MINUS: mod   = false; break;
+        case keys::KEY_PLUS:
+        case keys::KEY_MINUS:
+            mod = false;
+            stepFraction = 0.0f;
+            if (scheduler != NULL)
+                logger.info << "Physics step time: "
+                            << scheduler->GetStepTime() << " usec" << logger.end;
+            break;
 
         default: break;
         }
@@ -128,34 +125,23 @@ void KeyboardHandler::Handle(JoystickButtonEventArg arg) {
     switch (arg.button) {
     case keys::JBUTTON_TWO: {
 	if (arg.type == JoystickButtonEventArg::PRESS) {
-	    box->AddForce(Vector<3,float>(0,5000,0));
+	    Send(PhysicsCommand::Impulse(Vector<3,float>(0,5000,0)));
 	}
 	break;
     }
     case keys::JBUTTON_TEN: {
-	physics->Handle(InitializeEventArg());
-	if( physics != NULL ){
-	    if( box != NULL ) {
-		box->ResetForces();
-		box->SetCenter( Vector<3,float>(2, 1, 2) );
-		logger.info << "Reset Physics" << logger.end;
-	    }
-	}
+	Send(PhysicsCommand::Reset());
 	break;
     }
     case keys::JBUTTON_SEVEN: {
 	if (arg.type == JoystickButtonEventArg::PRESS) {
-	    Vector<3,float> g = box->GetGravity();
-	    box->SetGravity(g*10.0);
-	    logger.info << "Gravity " << g << logger.end;
+	    Send(PhysicsCommand::Gravity(10.0));
 	}
 	break;
     }
     case keys::JBUTTON_EIGHT: {
 	if (arg.type == JoystickButtonEventArg::PRESS) {
-	    Vector<3,float> g = box->GetGravity();
-	    box->SetGravity(g/10.0);
-	    logger.info << "Gravity " << g << logger.end;
+	    Send(PhysicsCommand::Gravity(0.1));
 	}
 	break;
     }
@@ -176,3 +162,39 @@ void KeyboardHandler::Handle(JoystickAxisEventArg arg) {
     right = (arg.state.axisState[0])/max;
     
 }
+
+// Use a constant time step for the applied forces instead of the
+// measured frame time, so recorded input replays identically.
+void KeyboardHandler::SetFixedDelta(float delta) {
+    fixedDelta = delta;
+}
+
+// Send commands to a physics running on another thread instead of
+// applying them to the physics and the box directly.
+void KeyboardHandler::SetCommandQueue(PhysicsCommandQueue* queue) {
+    commands = queue;
+}
+
+// Let the plus and minus keys change the step time of the physics.
+void KeyboardHandler::SetScheduler(PhysicsScheduler* scheduler) {
+    this->scheduler = scheduler;
+}
+
+// The driving controls reach the physics through the input queue
+// instead of once per frame from this handler.
+void KeyboardHandler::SetInputQueue(InputQueue* input) {
+    this->input = input;
+}
+
+// Reset and rewind through the physics snapshots. Only used when
+// the commands are applied directly.
+void KeyboardHandler::SetSnapshots(PhysicsSnapshots* snapshots) {
+    this->snapshots = snapshots;
+}
+
+void KeyboardHandler::Send(const PhysicsCommand& cmd) {
+    if (commands == NULL)
+        LogPhysicsCommand(ApplyPhysicsCommand(cmd, physics, box, snapshots));
+    else if (!commands->Push(cmd))
+        logger.warning << "Physics command queue is full" << logger.end;
+}
@@ -12,6 +12,10 @@
 #include <Math/Matrix.h>
 #include <Utils/Timer.h>
 
+#include "PhysicsCommand.h"
+#include "PhysicsScheduler.h"
+#include "InputQueue.h"
+
 using OpenEngine::Core::IModule;
 using OpenEngine::Core::IListener;
 using OpenEngine::Core::IEngine;
@@ -31,14 +35,25 @@ class KeyboardHandler : public IModule, public IListener<KeyboardEventArg>,
 			public IListener<JoystickButtonEventArg>,
 			public IListener<JoystickAxisEventArg> {
     
+public:
+    static const unsigned int REWIND_STEPS = 100;
+
 private:
     float up, down, left, right, mod;
     float step;
+    float stepFraction;     // usec of adjustment not yet applied
+    float fixedDelta;
     Camera* camera;
     RigidBox* box;
     FixedTimeStepPhysics* physics;
     IEngine& engine;
     Timer timer;
+    PhysicsCommandQueue* commands;
+    PhysicsScheduler* scheduler;
+    InputQueue* input;
+    PhysicsSnapshots* snapshots;
+
+    void Send(const PhysicsCommand& cmd);
 
 public:
     KeyboardHandler(IEngine& engine,
@@ -55,6 +70,12 @@ public:
     void Handle(JoystickButtonEventArg arg);
     void Handle(JoystickAxisEventArg arg);
 
+    void SetFixedDelta(float delta);
+    void SetCommandQueue(PhysicsCommandQueue* queue);
+    void SetScheduler(PhysicsScheduler* scheduler);
+    void SetInputQueue(InputQueue* input);
+    void SetSnapshots(PhysicsSnapshots* snapshots);
+
 
 };
 
@@ -0,0 +1,176 @@
+#include "LODSelector.h"
+#include "MeshSimplifier.h"
+
+#include <Geometry/FaceSet.h>
+#include <Logging/Logger.h>
+#include <Scene/GeometryNode.h>
+#include <Scene/SceneNode.h>
+
+#include <algorithm>
+
+using OpenEngine::Geometry::FaceList;
+using OpenEngine::Scene::GeometryNode;
+using OpenEngine::Scene::SceneNode;
+
+namespace {
+void CollectGeometry(ISceneNode* node, vector<GeometryNode*>& nodes) {
+    GeometryNode* geom = dynamic_cast<GeometryNode*>(node);
+    if (geom != NULL) nodes.push_back(geom);
+    for (unsigned int i = 0; i < node->GetNumberOfNodes(); i++)
+        CollectGeometry(node->GetNode(i), nodes);
+}
+
+// Grid resolutions of the coarser levels, in cells along the
+// largest side of the geometry
+const float RESOLUTION[3] = { 64, 24, 8 };
+}
+
+LODSelector::LODSelector(Camera& camera)
+    : camera(camera)
+    , distanceScale(1)
+    , hysteresis(0.1f)
+    , submitted(0)
+    , full(0)
+    , totalSubmitted(0)
+    , totalFull(0)
+    , frames(0)
+    , switches(0)
+{
+    SetDistances(500, 1000, 2000);
+}
+
+void LODSelector::SetDistances(float level1, float level2, float level3) {
+    distances.clear();
+    distances.push_back(0);
+    distances.push_back(level1);
+    distances.push_back(level2);
+    distances.push_back(level3);
+}
+
+void LODSelector::SetHysteresis(float fraction) {
+    hysteresis = fraction;
+}
+
+void LODSelector::SetDistanceScale(float scale) {
+    distanceScale = scale;
+}
+
+float LODSelector::GetDistanceScale() const {
+    return distanceScale;
+}
+
+void LODSelector::Build(ISceneNode& scene, unsigned int minFaces) {
+    vector<GeometryNode*> geoms;
+    CollectGeometry(&scene, geoms);
+
+    unsigned int levels = 0;
+    for (unsigned int i = 0; i < geoms.size(); i++) {
+        GeometryNode* geom = geoms[i];
+        FaceSet* fs = geom->GetFaceSet();
+        ISceneNode* parent = geom->GetParent();
+        if (fs == NULL || parent == NULL || fs->Size() < minFaces) continue;
+
+        Group g;
+        g.current = 0;
+        Vector<3,float> min = (*fs->begin())->vert[0], max = min;
+        for (FaceList::iterator itr = fs->begin(); itr != fs->end(); itr++)
+            for (int v = 0; v < 3; v++)
+                for (int k = 0; k < 3; k++) {
+                    min[k] = std::min(min[k], (*itr)->vert[v][k]);
+                    max[k] = std::max(max[k], (*itr)->vert[v][k]);
+                }
+        g.center = (min + max) * 0.5f;
+        float extent = std::max(max[0] - min[0],
+                                std::max(max[1] - min[1], max[2] - min[2]));
+
+        // The group node takes the place of the geometry node
+        g.node = new SceneNode();
+        parent->RemoveNode(geom);
+        parent->AddNode(g.node);
+        ISceneNode* level = new SceneNode();
+        level->AddNode(geom);
+        g.levels.push_back(level);
+        g.faces.push_back(fs->Size());
+        g.node->AddNode(level);
+
+        for (unsigned int r = 0; r < 3 && extent > 0; r++) {
+            FaceSet* simple = MeshSimplifier::Simplify(*fs, extent / RESOLUTION[r]);
+            if (simple->Size() == 0 || simple->Size() > g.faces.back() * 0.8f) {
+                delete simple;
+                continue;
+            }
+            level = new SceneNode();
+            level->AddNode(new GeometryNode(simple));
+            g.levels.push_back(level);
+            g.faces.push_back(simple->Size());
+        }
+        levels += g.levels.size();
+        groups.push_back(g);
+    }
+    logger.info << "Built " << levels << " detail levels for "
+                << groups.size() << " geometry nodes" << logger.end;
+}
+
+void LODSelector::Select(Vector<3,float> viewer) {
+    submitted = full = 0;
+    for (unsigned int i = 0; i < groups.size(); i++) {
+        Group& g = groups[i];
+        float d = (g.center - viewer).GetLength() / distanceScale;
+        unsigned int level = g.current;
+        const unsigned int top = std::min(g.levels.size(), distances.size()) - 1;
+        while (level < top && d > distances[level + 1] * (1 + hysteresis))
+            level++;
+        while (level > 0 && d < distances[level] * (1 - hysteresis))
+            level--;
+        if (level != g.current) {
+            g.node->RemoveNode(g.levels[g.current]);
+            g.node->AddNode(g.levels[level]);
+            g.current = level;
+            switches++;
+        }
+        submitted += g.faces[level];
+        full += g.faces[0];
+    }
+    totalSubmitted += submitted;
+    totalFull += full;
+    frames++;
+}
+
+// The levels not shown by their group, and so not in the scene
+vector<ISceneNode*> LODSelector::GetDetachedLevels() const {
+    vector<ISceneNode*> levels;
+    for (unsigned int i = 0; i < groups.size(); i++)
+        for (unsigned int j = 0; j < groups[i].levels.size(); j++)
+            if (j != groups[i].current)
+                levels.push_back(groups[i].levels[j]);
+    return levels;
+}
+
+unsigned int LODSelector::GetGroupCount() const {
+    return groups.size();
+}
+
+unsigned int LODSelector::GetSubmittedFaces() const {
+    return submitted;
+}
+
+unsigned int LODSelector::GetFullFaces() const {
+    return full;
+}
+
+void LODSelector::Handle(InitializeEventArg arg) {
+    totalSubmitted = totalFull = 0;
+    frames = switches = 0;
+}
+
+void LODSelector::Handle(ProcessEventArg arg) {
+    Select(camera.GetPosition());
+}
+
+void LODSelector::Handle(DeinitializeEventArg arg) {
+    if (frames == 0) return;
+    logger.info << "Level of detail: " << totalSubmitted / frames
+                << " faces submitted per frame of " << totalFull / frames
+                << " at full detail, " << switches << " level switches"
+                << logger.end;
+}
@@ -0,0 +1,93 @@
+// Distance based level of detail for the static scene.
+// -------------------------------------------------------------------
+// Copyright (C) 2007 OpenEngine.dk (See AUTHORS)
+//
+// This program is free software; It is covered by the GNU General
+// Public License version 2 or any later version.
+// See the GNU General Public License for more details (see LICENSE).
+//--------------------------------------------------------------------
+
+#ifndef _LOD_SELECTOR_
+#define _LOD_SELECTOR_
+
+#include <Core/IModule.h>
+#include <Display/Camera.h>
+#include <Scene/ISceneNode.h>
+
+#include <vector>
+
+using OpenEngine::Core::IModule;
+using OpenEngine::Core::InitializeEventArg;
+using OpenEngine::Core::ProcessEventArg;
+using OpenEngine::Core::DeinitializeEventArg;
+using OpenEngine::Display::Camera;
+using OpenEngine::Scene::ISceneNode;
+using std::vector;
+
+/**
+ * Switches the geometry of a scene between levels of detail by the
+ * distance to the camera.
+ *
+ * Build replaces every geometry node with enough faces by a group
+ * node holding one of its levels. Level 0 is the original geometry,
+ * the coarser levels are made with the MeshSimplifier on grids
+ * relative to the size of the geometry; a level that does not remove
+ * at least a fifth of the faces of the previous one is not kept.
+ * On the static scene this works per quad tree cell.
+ *
+ * Every frame each group shows level i when the camera is further
+ * than distance i from its center. A group only moves to a coarser
+ * level once the distance exceeds the switch distance by the
+ * hysteresis fraction, and back once it is below it by the same
+ * fraction, so levels do not pop back and forth at the boundary.
+ * The distances are multiplied by a scale, lowered to switch to the
+ * coarser levels sooner.
+ *
+ * The faces of the shown levels are counted as submitted faces per
+ * frame, next to the faces at full detail, and the averages are
+ * logged on deinitialize.
+ */
+class LODSelector : public IModule {
+private:
+    struct Group {
+        ISceneNode* node;
+        vector<ISceneNode*> levels;
+        vector<unsigned int> faces;
+        Vector<3,float> center;
+        unsigned int current;
+    };
+
+    Camera& camera;
+    vector<Group> groups;
+    vector<float> distances;
+    float distanceScale;
+    float hysteresis;
+    unsigned int submitted;
+    unsigned int full;
+    unsigned long long totalSubmitted;
+    unsigned long long totalFull;
+    unsigned int frames;
+    unsigned int switches;
+
+public:
+    LODSelector(Camera& camera);
+
+    void Build(ISceneNode& scene, unsigned int minFaces = 200);
+    void SetDistances(float level1, float level2, float level3);
+    void SetHysteresis(float fraction);
+    void SetDistanceScale(float scale);
+    float GetDistanceScale() const;
+
+    void Select(Vector<3,float> viewer);
+
+    vector<ISceneNode*> GetDetachedLevels() const;
+    unsigned int GetGroupCount() const;
+    unsigned int GetSubmittedFaces() const;
+    unsigned int GetFullFaces() const;
+
+    void Handle(InitializeEventArg arg);
+    void Handle(ProcessEventArg arg);
+    void Handle(DeinitializeEventArg arg);
+};
+
+#endif
@@ -0,0 +1,177 @@
+// Lock free structures for passing data between threads.
+// -------------------------------------------------------------------
+// Copyright (C) 2007 OpenEngine.dk (See AUTHORS)
+//
+// This program is free software; It is covered by the GNU General
+// Public License version 2 or any later version.
+// See the GNU General Public License for more details (see LICENSE).
+//--------------------------------------------------------------------
+
+#ifndef _LOCK_FREE_
+#define _LOCK_FREE_
+
+#ifdef _WIN32
+#include <windows.h>
+#define LOCKFREE_BARRIER() MemoryBarrier()
+#define LOCKFREE_EXCHANGE(ptr, value) \
+    InterlockedExchange((volatile LONG*)(ptr), (LONG)(value))
+#define LOCKFREE_ADD(ptr, value) \
+    (InterlockedExchangeAdd((volatile LONG*)(ptr), (LONG)(value)) + (value))
+#define LOCKFREE_CAS(ptr, old, value) \
+    (InterlockedCompareExchange((volatile LONG*)(ptr), \
+                                (LONG)(value), (LONG)(old)) == (LONG)(old))
+#else
+#define LOCKFREE_BARRIER() __sync_synchronize()
+#define LOCKFREE_EXCHANGE(ptr, value) \
+    __sync_lock_test_and_set((ptr), (value))
+#define LOCKFREE_ADD(ptr, value) \
+    __sync_add_and_fetch((ptr), (value))
+#define LOCKFREE_CAS(ptr, old, value) \
+    __sync_bool_compare_and_swap((ptr), (old), (value))
+#endif
+
+/**
+ * Bounded single producer, single consumer queue.
+ *
+ * One thread may Push and one other thread may Pop. Neither call
+ * blocks or allocates; Push fails when the queue is full and Pop
+ * fails when it is empty. N must be a power of two.
+ */
+template <class T, unsigned int N>
+class LockFreeQueue {
+private:
+    T items[N];
+    volatile unsigned int head;   // next slot to pop, owned by consumer
+    volatile unsigned int tail;   // next slot to push, owned by producer
+
+public:
+    LockFreeQueue() : head(0), tail(0) {}
+
+    bool Push(const T& item) {
+        unsigned int t = tail;
+        if (t - head == N) return false;
+        items[t & (N - 1)] = item;
+        LOCKFREE_BARRIER();
+        tail = t + 1;
+        return true;
+    }
+
+    bool Pop(T& item) {
+        unsigned int h = head;
+        if (h == tail) return false;
+        LOCKFREE_BARRIER();
+        item = items[h & (N - 1)];
+        LOCKFREE_BARRIER();
+        head = h + 1;
+        return true;
+    }
+
+    bool IsEmpty() const {
+        return head == tail;
+    }
+
+    unsigned int Size() const {
+        return tail - head;
+    }
+};
+
+/**
+ * Bounded multiple producer, single consumer queue.
+ *
+ * Any number of threads may Push and one thread may Pop. Every slot
+ * carries a sequence number telling whether it is free for the
+ * producer of a given position or filled for the consumer. Producers
+ * claim a position by advancing the tail with a compare and swap and
+ * then fill the slot without holding anything, so a producer never
+ * waits for another. Push fails when the queue is full and Pop fails
+ * when the next slot is empty or still being filled. N must be a
+ * power of two.
+ */
+template <class T, unsigned int N>
+class LockFreeRing {
+private:
+    struct Slot {
+        volatile unsigned int sequence;
+        T item;
+    };
+
+    Slot slots[N];
+    volatile unsigned int tail;   // next position to claim, shared by producers
+    unsigned int head;            // next position to pop, owned by consumer
+
+public:
+    LockFreeRing() : tail(0), head(0) {
+        for (unsigned int i = 0; i < N; i++)
+            slots[i].sequence = i;
+    }
+
+    bool Push(const T& item) {
+        for (;;) {
+            unsigned int t = tail;
+            Slot& slot = slots[t & (N - 1)];
+            int diff = (int)(slot.sequence - t);
+            if (diff < 0) return false;
+            if (diff == 0 && LOCKFREE_CAS(&tail, t, t + 1)) {
+                slot.item = item;
+                LOCKFREE_BARRIER();
+                slot.sequence = t + 1;
+                return true;
+            }
+        }
+    }
+
+    bool Pop(T& item) {
+        Slot& slot = slots[head & (N - 1)];
+        if ((int)(slot.sequence - (head + 1)) < 0) return false;
+        LOCKFREE_BARRIER();
+        item = slot.item;
+        LOCKFREE_BARRIER();
+        slot.sequence = head + N;
+        head++;
+        return true;
+    }
+};
+
+/**
+ * Triple buffer for publishing snapshots from one thread to another.
+ *
+ * The writer fills the back buffer and publishes it with Publish,
+ * which swaps it with the middle buffer. The reader calls Update to
+ * swap a newly published middle buffer to the front, and reads the
+ * front. Neither side ever waits for the other, and the reader
+ * always sees a complete snapshot.
+ */
+template <class T>
+class TripleBuffer {
+private:
+    static const unsigned int FRESH = 4;   // set when middle is new
+
+    T buffers[3];
+    unsigned int back, front;
+    volatile unsigned int middle;
+
+public:
+    TripleBuffer() : back(0), front(1), middle(2) {}
+
+    T& Back() {
+        return buffers[back];
+    }
+
+    void Publish() {
+        LOCKFREE_BARRIER();
+        back = LOCKFREE_EXCHANGE(&middle, back | FRESH) & 3;
+    }
+
+    bool Update() {
+        if ((middle & FRESH) == 0) return false;
+        front = LOCKFREE_EXCHANGE(&middle, front) & 3;
+        LOCKFREE_BARRIER();
+        return true;
+    }
+
+    const T& Front() const {
+        return buffers[front];
+    }
+};
+
+#endif
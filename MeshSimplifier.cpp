@@ -0,0 +1,71 @@
+#include "MeshSimplifier.h"
+
+#include <cmath>
+#include <map>
+
+using OpenEngine::Geometry::Face;
+using OpenEngine::Geometry::FaceList;
+using OpenEngine::Geometry::FacePtr;
+using std::map;
+
+namespace {
+struct Cell {
+    int x, y, z;
+    bool operator<(const Cell& o) const {
+        if (x != o.x) return x < o.x;
+        if (y != o.y) return y < o.y;
+        return z < o.z;
+    }
+    bool operator==(const Cell& o) const {
+        return x == o.x && y == o.y && z == o.z;
+    }
+};
+
+struct Cluster {
+    Vector<3,float> sum;
+    unsigned int count;
+    Cluster() : sum(0,0,0), count(0) {}
+};
+
+Cell CellOf(const Vector<3,float>& p, float size) {
+    Cell c = { (int)floor(p[0] / size),
+               (int)floor(p[1] / size),
+               (int)floor(p[2] / size) };
+    return c;
+}
+}
+
+FaceSet* MeshSimplifier::Simplify(FaceSet& faces, float cellSize) {
+    map<Cell, Cluster> clusters;
+    for (FaceList::iterator itr = faces.begin(); itr != faces.end(); itr++)
+        for (int k = 0; k < 3; k++) {
+            Cluster& c = clusters[CellOf((*itr)->vert[k], cellSize)];
+            c.sum += (*itr)->vert[k];
+            c.count++;
+        }
+
+    FaceSet* simple = new FaceSet();
+    for (FaceList::iterator itr = faces.begin(); itr != faces.end(); itr++) {
+        FacePtr f = *itr;
+        Cell cell[3];
+        for (int k = 0; k < 3; k++)
+            cell[k] = CellOf(f->vert[k], cellSize);
+        if (cell[0] == cell[1] || cell[1] == cell[2] || cell[0] == cell[2])
+            continue;
+
+        Vector<3,float> p[3];
+        for (int k = 0; k < 3; k++) {
+            const Cluster& c = clusters[cell[k]];
+            p[k] = c.sum / (float)c.count;
+        }
+        FacePtr face(new Face(p[0], p[1], p[2]));
+        for (int k = 0; k < 3; k++) {
+            face->norm[k] = f->norm[k];
+            face->texc[k] = f->texc[k];
+            face->colr[k] = f->colr[k];
+        }
+        face->mat = f->mat;
+        simple->Add(face);
+    }
+    return simple;
+}
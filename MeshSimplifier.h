@@ -0,0 +1,29 @@
+// Vertex clustering mesh simplification.
+// -------------------------------------------------------------------
+// Copyright (C) 2007 OpenEngine.dk (See AUTHORS)
+//
+// This program is free software; It is covered by the GNU General
+// Public License version 2 or any later version.
+// See the GNU General Public License for more details (see LICENSE).
+//--------------------------------------------------------------------
+
+#ifndef _MESH_SIMPLIFIER_
+#define _MESH_SIMPLIFIER_
+
+#include <Geometry/FaceSet.h>
+
+using OpenEngine::Geometry::FaceSet;
+
+/**
+ * Simplifies a face set by clustering its vertices on a uniform
+ * grid. All vertices in a grid cell are moved to their average
+ * position, and faces with two corners in the same cell disappear.
+ * Normals, texture coordinates, colors and materials are kept from
+ * the original corners. The input is not changed.
+ */
+class MeshSimplifier {
+public:
+    static FaceSet* Simplify(FaceSet& faces, float cellSize);
+};
+
+#endif
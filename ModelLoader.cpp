@@ -0,0 +1,275 @@
+#include "ModelLoader.h"
+
+#include <Core/Exceptions.h>
+#include <Core/Mutex.h>
+#include <Core/Thread.h>
+#include <Resources/DirectoryManager.h>
+#include <Resources/File.h>
+#include <Resources/ResourceManager.h>
+#include <Utils/Timer.h>
+
+#include <cstdlib>
+#include <set>
+#include <sstream>
+
+using OpenEngine::Core::Exception;
+using OpenEngine::Core::Mutex;
+using OpenEngine::Core::Thread;
+using OpenEngine::Resources::DirectoryManager;
+using OpenEngine::Resources::File;
+using OpenEngine::Resources::IModelResource;
+using OpenEngine::Resources::ITextureResource;
+using OpenEngine::Resources::ResourceManager;
+using OpenEngine::Utils::Timer;
+using std::ifstream;
+using std::set;
+
+namespace {
+
+// Load a single entry. The resource is unloaded again right away,
+// the scene node stays alive and is handed over to the entry.
+void LoadEntry(ModelEntry& entry, Timer& clock) {
+    entry.loadStart = clock.GetElapsedTime().AsInt();
+    Timer timer;
+    timer.Start();
+    entry.resource->Load();
+    entry.node = entry.resource->GetSceneNode();
+    entry.resource->Unload();
+    entry.loadTime = timer.GetElapsedTime().AsInt();
+}
+
+// Load the entries of one file. The file is parsed for the first
+// entry only, the others get copies sharing its geometry.
+void LoadGroup(vector<ModelEntry>& entries,
+               const vector<unsigned int>& group,
+               GeometryCache& cache,
+               Timer& clock) {
+    ModelEntry& first = entries[group[0]];
+    LoadEntry(first, clock);
+    for (unsigned int i = 1; i < group.size(); i++) {
+        ModelEntry& entry = entries[group[i]];
+        entry.loadStart = clock.GetElapsedTime().AsInt();
+        Timer timer;
+        timer.Start();
+        entry.node = cache.Share(first.node);
+        entry.loadTime = timer.GetElapsedTime().AsInt();
+    }
+}
+
+// Values of the lines starting with the keyword, e.g. the mtllib
+// lines of an OBJ file or the map_Kd lines of a material library
+void ReadValues(string path, string keyword, vector<string>& values) {
+    ifstream in(path.c_str());
+    string line;
+    while (getline(in, line)) {
+        std::istringstream words(line);
+        string key, value;
+        words >> key;
+        if (key != keyword) continue;
+        getline(words >> std::ws, value);
+        if (!value.empty() && value[value.size() - 1] == '\r')
+            value.erase(value.size() - 1);
+        if (!value.empty()) values.push_back(value);
+    }
+}
+
+// Texture names in the material libraries of an OBJ file. Libraries
+// are looked for next to the model first.
+void ReadTextureNames(string file, set<string>& names) {
+    string path = DirectoryManager::FindFileInPath(file);
+    string dir = path.substr(0, path.find_last_of("/\\") + 1);
+    vector<string> libraries;
+    ReadValues(path, "mtllib", libraries);
+    for (unsigned int i = 0; i < libraries.size(); i++) {
+        string library = dir + libraries[i];
+        if (!File::Exists(library))
+            library = DirectoryManager::FindFileInPath(libraries[i]);
+        vector<string> textures;
+        ReadValues(library, "map_Kd", textures);
+        names.insert(textures.begin(), textures.end());
+    }
+}
+
+// Work shared between the loader threads. A job is the list of
+// entries referring to the same file.
+struct LoadJobs {
+    vector<ModelEntry>& entries;
+    vector< vector<unsigned int> >& groups;
+    GeometryCache& cache;
+    Timer& clock;
+    unsigned int next;
+    Mutex lock;
+    LoadJobs(vector<ModelEntry>& entries,
+             vector< vector<unsigned int> >& groups,
+             GeometryCache& cache,
+             Timer& clock)
+        : entries(entries), groups(groups), cache(cache), clock(clock), next(0) {}
+};
+
+class LoadWorker : public Thread {
+private:
+    LoadJobs& jobs;
+public:
+    LoadWorker(LoadJobs& jobs) : jobs(jobs) {}
+    void Run() {
+        for (;;) {
+            jobs.lock.Lock();
+            unsigned int job = jobs.next++;
+            jobs.lock.Unlock();
+            if (job >= jobs.groups.size()) return;
+            LoadGroup(jobs.entries, jobs.groups[job], jobs.cache, jobs.clock);
+        }
+    }
+};
+
+} // anonymous namespace
+
+ModelLoader::ModelLoader(unsigned int threads)
+    : threads(threads)
+    , loadTime(0)
+{}
+
+void ModelLoader::ReadManifest(string manifest) {
+    ifstream* mfile = File::Open(manifest);
+    if (mfile == NULL)
+        throw Exception("Can not open model manifest: " + manifest);
+
+    ModelEntry::Section section = ModelEntry::DEFAULT;
+    while (!mfile->eof()) {
+        string mod_str;
+        getline(*mfile, mod_str);
+
+        // Check the string
+        if (mod_str[0] == '#' || mod_str == "") continue;
+
+        // switch section
+        if (mod_str == "dynamic") {
+            section = ModelEntry::DYNAMIC;
+            continue;
+        }
+        else if (mod_str == "static") {
+            section = ModelEntry::STATIC;
+            continue;
+        }
+        else if (mod_str == "physic") {
+            section = ModelEntry::PHYSIC;
+            continue;
+        }
+        else if (mod_str.compare(0, 4, "set ") == 0) {
+            std::istringstream line(mod_str.substr(4));
+            string name, value;
+            line >> name >> value;
+            settings[name] = value;
+            continue;
+        }
+
+        ModelEntry entry;
+        entry.section = section;
+        entry.file = mod_str;
+        entry.node = NULL;
+        entry.loadStart = 0;
+        entry.loadTime = 0;
+        entries.push_back(entry);
+    }
+    mfile->close();
+    delete mfile;
+}
+
+// Drop all entries of other sections
+void ModelLoader::SelectSection(ModelEntry::Section section) {
+    vector<ModelEntry> selected;
+    for (unsigned int i = 0; i < entries.size(); i++)
+        if (entries[i].section == section)
+            selected.push_back(entries[i]);
+    entries.swap(selected);
+}
+
+// Drop all entries of the section
+void ModelLoader::RemoveSection(ModelEntry::Section section) {
+    vector<ModelEntry> selected;
+    for (unsigned int i = 0; i < entries.size(); i++)
+        if (entries[i].section != section)
+            selected.push_back(entries[i]);
+    entries.swap(selected);
+}
+
+unsigned int ModelLoader::GetSetting(string name, unsigned int value) const {
+    map<string, string>::const_iterator itr = settings.find(name);
+    if (itr == settings.end()) return value;
+    return atoi(itr->second.c_str());
+}
+
+void ModelLoader::Load() {
+    clock.Reset();
+    clock.Start();
+
+    // The resource manager is not thread safe, so all resources are
+    // created up front on the calling thread.
+    for (unsigned int i = 0; i < entries.size(); i++)
+        entries[i].resource = ResourceManager<IModelResource>::Create(entries[i].file);
+
+    // Group the entries by file, in order of first appearance
+    vector< vector<unsigned int> > groups;
+    map<string, unsigned int> groupOf;
+    for (unsigned int i = 0; i < entries.size(); i++) {
+        map<string, unsigned int>::iterator itr = groupOf.find(entries[i].file);
+        if (itr == groupOf.end()) {
+            groupOf[entries[i].file] = groups.size();
+            groups.push_back(vector<unsigned int>(1, i));
+        } else
+            groups[itr->second].push_back(i);
+    }
+
+    Timer timer;
+    timer.Start();
+    if (threads == 0) LoadSerial(groups);
+    else {
+        CreateTextures(groups);
+        LoadParallel(groups);
+    }
+    loadTime = timer.GetElapsedTime().AsInt();
+}
+
+// Create the textures of the models on the calling thread, ahead of
+// the lookups of the OBJ plugin on the worker threads
+void ModelLoader::CreateTextures(vector< vector<unsigned int> >& groups) {
+    set<string> names;
+    for (unsigned int i = 0; i < groups.size(); i++)
+        ReadTextureNames(entries[groups[i][0]].file, names);
+    for (set<string>::iterator itr = names.begin(); itr != names.end(); itr++)
+        textures.push_back(ResourceManager<ITextureResource>::Create(*itr));
+}
+
+void ModelLoader::LoadSerial(vector< vector<unsigned int> >& groups) {
+    for (unsigned int i = 0; i < groups.size(); i++)
+        LoadGroup(entries, groups[i], cache, clock);
+}
+
+void ModelLoader::LoadParallel(vector< vector<unsigned int> >& groups) {
+    LoadJobs jobs(entries, groups, cache, clock);
+    vector<LoadWorker*> workers;
+    for (unsigned int i = 0; i < threads; i++) {
+        workers.push_back(new LoadWorker(jobs));
+        workers.back()->Start();
+    }
+    for (unsigned int i = 0; i < workers.size(); i++) {
+        workers[i]->Wait();
+        delete workers[i];
+    }
+}
+
+vector<ModelEntry>& ModelLoader::GetEntries() {
+    return entries;
+}
+
+unsigned int ModelLoader::GetThreadCount() const {
+    return threads;
+}
+
+unsigned int ModelLoader::GetLoadTime() const {
+    return loadTime;
+}
+
+const GeometryCache& ModelLoader::GetGeometryCache() const {
+    return cache;
+}
@@ -0,0 +1,97 @@
+// Model manifest loader.
+// -------------------------------------------------------------------
+// Copyright (C) 2007 OpenEngine.dk (See AUTHORS)
+//
+// This program is free software; It is covered by the GNU General
+// Public License version 2 or any later version.
+// See the GNU General Public License for more details (see LICENSE).
+//--------------------------------------------------------------------
+
+#ifndef _MODEL_LOADER_
+#define _MODEL_LOADER_
+
+#include <Resources/IModelResource.h>
+#include <Resources/ITextureResource.h>
+#include <Scene/ISceneNode.h>
+
+#include "GeometryCache.h"
+
+#include <Utils/Timer.h>
+
+#include <map>
+#include <string>
+#include <vector>
+
+using OpenEngine::Resources::IModelResourcePtr;
+using OpenEngine::Resources::ITextureResourcePtr;
+using OpenEngine::Scene::ISceneNode;
+using OpenEngine::Utils::Timer;
+using std::map;
+using std::string;
+using std::vector;
+
+/**
+ * A single model line of the model manifest (models.txt).
+ * Models listed before the first section header are in the DEFAULT
+ * section.
+ */
+struct ModelEntry {
+    enum Section { DEFAULT, DYNAMIC, STATIC, PHYSIC };
+    Section section;
+    string file;
+    IModelResourcePtr resource;
+    ISceneNode* node;   // NULL until loaded (or if loading failed)
+    unsigned int loadStart; // usec after Load was called
+    unsigned int loadTime;  // usec
+};
+
+/**
+ * Reads the model manifest and loads the listed models.
+ *
+ * The manifest is read completely before anything is loaded. Models
+ * are then loaded either serially or on a pool of worker threads.
+ * Entries naming the same file share a resource and are loaded by
+ * the same worker. The file is only parsed once, the other entries
+ * get copies sharing its geometry through a GeometryCache. The
+ * entries keep manifest order regardless of the loading order, so
+ * the caller can build a deterministic scene graph from them.
+ *
+ * The resource manager is not thread safe, and the OBJ plugin looks
+ * up the textures of its materials while loading. Before the workers
+ * start, the textures named by the material libraries of the models
+ * are therefore created on the calling thread, so the lookups of the
+ * workers find them already created.
+ *
+ * Lines of the form "set <name> <value>" are settings and not models.
+ */
+class ModelLoader {
+private:
+    vector<ModelEntry> entries;
+    map<string, string> settings;
+    unsigned int threads;
+    unsigned int loadTime;
+    GeometryCache cache;
+    Timer clock;
+    vector<ITextureResourcePtr> textures;
+
+    void CreateTextures(vector< vector<unsigned int> >& groups);
+    void LoadSerial(vector< vector<unsigned int> >& groups);
+    void LoadParallel(vector< vector<unsigned int> >& groups);
+
+public:
+    ModelLoader(unsigned int threads = 0);
+
+    void ReadManifest(string manifest);
+    void SelectSection(ModelEntry::Section section);
+    void RemoveSection(ModelEntry::Section section);
+    void Load();
+
+    unsigned int GetSetting(string name, unsigned int value) const;
+
+    vector<ModelEntry>& GetEntries();
+    unsigned int GetThreadCount() const;
+    unsigned int GetLoadTime() const;
+    const GeometryCache& GetGeometryCache() const;
+};
+
+#endif
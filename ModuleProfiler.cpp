@@ -0,0 +1,153 @@
+#include "ModuleProfiler.h"
+
+#include <Logging/Logger.h>
+
+#include <algorithm>
+#include <fstream>
+
+using std::ofstream;
+
+const unsigned int ModuleProfiler::WINDOW;
+
+ModuleProfiler::Proxy::Proxy(ModuleProfiler& profiler,
+                             IListener<ProcessEventArg>& listener,
+                             unsigned int module)
+    : profiler(profiler)
+    , listener(listener)
+    , module(module)
+{}
+
+void ModuleProfiler::Proxy::Handle(ProcessEventArg arg) {
+    unsigned int start = profiler.timer.GetElapsedTime().AsInt();
+    listener.Handle(arg);
+    unsigned int end = profiler.timer.GetElapsedTime().AsInt();
+    profiler.Record(module, start, end);
+}
+
+ModuleProfiler::ModuleProfiler(unsigned int traceCapacity)
+    : traceCapacity(traceCapacity)
+    , dropped(0)
+{
+    trace.reserve(traceCapacity);
+    timer.Start();
+}
+
+ModuleProfiler::~ModuleProfiler() {
+    for (unsigned int i = 0; i < proxies.size(); i++)
+        delete proxies[i];
+}
+
+void ModuleProfiler::Attach(IEvent<ProcessEventArg>& event,
+                            IListener<ProcessEventArg>& listener,
+                            string name) {
+    Module m;
+    m.name = name;
+    m.window.resize(WINDOW, 0);
+    m.next = m.count = m.max = 0;
+    m.total = 0;
+    modules.push_back(m);
+
+    Proxy* proxy = new Proxy(*this, listener, modules.size() - 1);
+    proxies.push_back(proxy);
+    event.Attach(*proxy);
+}
+
+void ModuleProfiler::Record(unsigned int module,
+                            unsigned int start,
+                            unsigned int end) {
+    unsigned int time = end - start;
+    Module& m = modules[module];
+    m.window[m.next] = time;
+    m.next = (m.next + 1) % WINDOW;
+    m.count++;
+    m.total += time;
+    if (time > m.max) m.max = time;
+
+    if (trace.size() < traceCapacity) {
+        TraceEvent e = { module, start, time };
+        trace.push_back(e);
+    } else
+        dropped++;
+}
+
+void ModuleProfiler::SetTraceFile(string file) {
+    traceFile = file;
+}
+
+void ModuleProfiler::Handle(DeinitializeEventArg arg) {
+    LogSummary();
+    if (traceFile.empty()) return;
+    if (traceFile.size() > 4 &&
+        traceFile.substr(traceFile.size() - 4) == ".csv")
+        WriteCSV(traceFile);
+    else
+        WriteChromeTrace(traceFile);
+}
+
+unsigned int ModuleProfiler::GetModuleCount() const {
+    return modules.size();
+}
+
+const ModuleProfiler::Module& ModuleProfiler::GetModule(unsigned int module) const {
+    return modules[module];
+}
+
+unsigned int ModuleProfiler::GetPercentile(unsigned int module, float percentile) const {
+    const Module& m = modules[module];
+    unsigned int size = std::min(m.count, WINDOW);
+    if (size == 0) return 0;
+    vector<unsigned int> samples(m.window.begin(), m.window.begin() + size);
+    unsigned int n = (unsigned int)(percentile / 100.0f * (size - 1) + 0.5f);
+    std::nth_element(samples.begin(), samples.begin() + n, samples.end());
+    return samples[n];
+}
+
+void ModuleProfiler::LogSummary() const {
+    logger.info << "Module frame times in usec (p50/p95/p99/max/avg):" << logger.end;
+    for (unsigned int i = 0; i < modules.size(); i++) {
+        const Module& m = modules[i];
+        logger.info << "  " << m.name << ": "
+                    << GetPercentile(i, 50) << "/"
+                    << GetPercentile(i, 95) << "/"
+                    << GetPercentile(i, 99) << "/"
+                    << m.max << "/"
+                    << (m.count ? m.total / m.count : 0) << logger.end;
+    }
+    if (dropped)
+        logger.info << "  " << dropped << " trace events dropped" << logger.end;
+}
+
+bool ModuleProfiler::WriteChromeTrace(string file) const {
+    ofstream out(file.c_str());
+    if (!out.is_open()) {
+        logger.error << "Can not open '" << file << "' for output" << logger.end;
+        return false;
+    }
+    out << "{\"traceEvents\":[" << std::endl;
+    for (unsigned int i = 0; i < trace.size(); i++) {
+        const TraceEvent& e = trace[i];
+        out << "{\"name\":\"" << modules[e.module].name << "\","
+            << "\"ph\":\"X\",\"pid\":0,\"tid\":0,"
+            << "\"ts\":" << e.start << ",\"dur\":" << e.duration << "}"
+            << (i + 1 < trace.size() ? "," : "") << std::endl;
+    }
+    out << "]}" << std::endl;
+    logger.info << "Saved module trace to '" << file << "'" << logger.end;
+    return out.good();
+}
+
+bool ModuleProfiler::WriteCSV(string file) const {
+    ofstream out(file.c_str());
+    if (!out.is_open()) {
+        logger.error << "Can not open '" << file << "' for output" << logger.end;
+        return false;
+    }
+    out << "module,start_us,duration_us" << std::endl;
+    for (unsigned int i = 0; i < trace.size(); i++) {
+        const TraceEvent& e = trace[i];
+        out << modules[e.module].name << ","
+            << e.start << "," << e.duration << std::endl;
+    }
+    logger.info << "Saved module trace to '" << file << "'" << logger.end;
+    return out.good();
+}
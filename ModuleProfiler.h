@@ -0,0 +1,106 @@
+// Per module frame time profiler.
+// -------------------------------------------------------------------
+// Copyright (C) 2007 OpenEngine.dk (See AUTHORS)
+//
+// This program is free software; It is covered by the GNU General
+// Public License version 2 or any later version.
+// See the GNU General Public License for more details (see LICENSE).
+//--------------------------------------------------------------------
+
+#ifndef _MODULE_PROFILER_
+#define _MODULE_PROFILER_
+
+#include <Core/IListener.h>
+#include <Core/IEvent.h>
+#include <Core/EngineEvents.h>
+#include <Utils/Timer.h>
+
+#include <string>
+#include <vector>
+
+using OpenEngine::Core::IListener;
+using OpenEngine::Core::IEvent;
+using OpenEngine::Core::ProcessEventArg;
+using OpenEngine::Core::DeinitializeEventArg;
+using OpenEngine::Utils::Timer;
+using std::string;
+using std::vector;
+
+/**
+ * Measures the time each process event listener takes per frame.
+ *
+ * Listeners are attached through the profiler, which puts a timing
+ * proxy between the event and the listener. For every module the
+ * profiler keeps a rolling window of the latest samples, from which
+ * the percentiles are computed, along with the total count and the
+ * maximum. Every call is also recorded as a trace event (up to a
+ * fixed capacity) which can be written as Chrome trace JSON
+ * (chrome://tracing) or CSV.
+ *
+ * On deinitialize the profiler logs a summary and writes the trace
+ * file if one is set.
+ */
+class ModuleProfiler : public IListener<DeinitializeEventArg> {
+public:
+    static const unsigned int WINDOW = 1024;
+
+    struct Module {
+        string name;
+        vector<unsigned int> window;  // ring buffer of samples (usec)
+        unsigned int next;
+        unsigned int count;
+        unsigned int max;
+        unsigned long long total;
+    };
+
+private:
+    class Proxy : public IListener<ProcessEventArg> {
+    private:
+        ModuleProfiler& profiler;
+        IListener<ProcessEventArg>& listener;
+        unsigned int module;
+    public:
+        Proxy(ModuleProfiler& profiler,
+              IListener<ProcessEventArg>& listener,
+              unsigned int module);
+        void Handle(ProcessEventArg arg);
+    };
+    friend class Proxy;
+
+    struct TraceEvent {
+        unsigned int module;
+        unsigned int start;
+        unsigned int duration;
+    };
+
+    vector<Module> modules;
+    vector<Proxy*> proxies;
+    vector<TraceEvent> trace;
+    unsigned int traceCapacity;
+    unsigned int dropped;
+    string traceFile;
+    Timer timer;
+
+    void Record(unsigned int module, unsigned int start, unsigned int end);
+
+public:
+    ModuleProfiler(unsigned int traceCapacity = 100000);
+    virtual ~ModuleProfiler();
+
+    void Attach(IEvent<ProcessEventArg>& event,
+                IListener<ProcessEventArg>& listener,
+                string name);
+
+    void SetTraceFile(string file);
+    void Handle(DeinitializeEventArg arg);
+
+    unsigned int GetModuleCount() const;
+    const Module& GetModule(unsigned int module) const;
+    unsigned int GetPercentile(unsigned int module, float percentile) const;
+
+    void LogSummary() const;
+    bool WriteChromeTrace(string file) const;
+    bool WriteCSV(string file) const;
+};
+
+#endif
@@ -0,0 +1,115 @@
+// Serialization (must be first)
+#include <fstream>
+#include <Utils/Serialization.h>
+
+#include "PhysicsCache.h"
+
+#include <Logging/Logger.h>
+
+#include <cstdio>
+#include <cstring>
+#include <sstream>
+
+using OpenEngine::Utils::Serialization;
+using std::ifstream;
+using std::ofstream;
+using std::ios;
+
+namespace {
+const char MAGIC[4] = { 'O', 'E', 'P', 'C' };
+}
+
+PhysicsCache::PhysicsCache(string directory)
+    : directory(directory)
+{
+    AddParameter("version", VERSION);
+}
+
+void PhysicsCache::AddSource(string file) {
+    key.AddSource(file);
+}
+
+void PhysicsCache::AddParameter(string name, unsigned int value) {
+    key.AddParameter(name, value);
+}
+
+void PhysicsCache::AddSettings(const PhysicsTreeSettings& settings) {
+    AddParameter("quad.maxfacecount", settings.quadMaxFaceCount);
+    AddParameter("quad.maxquadsize",  settings.quadMaxQuadSize);
+}
+
+boost::uint64_t PhysicsCache::GetKey() const {
+    return key.Get();
+}
+
+string PhysicsCache::GetFileName() const {
+    std::ostringstream name;
+    name << directory << "oeracer-physics-"
+         << std::hex << key.Get() << ".bin";
+    return name.str();
+}
+
+bool PhysicsCache::Load(ISceneNode& root) {
+    ifstream isf(GetFileName().c_str(), ios::binary);
+    if (!isf.is_open()) return false;
+
+    char magic[4];
+    unsigned int version = 0;
+    boost::uint64_t fileKey = 0;
+    isf.read(magic, sizeof(magic));
+    isf.read((char*)&version, sizeof(version));
+    isf.read((char*)&fileKey, sizeof(fileKey));
+    if (!isf ||
+        memcmp(magic, MAGIC, sizeof(MAGIC)) != 0 ||
+        version != VERSION ||
+        fileKey != key.Get()) {
+        logger.info << "Physics cache " << GetFileName()
+                    << " is stale" << logger.end;
+        return false;
+    }
+
+    // A damaged tree is rebuilt like a stale one
+    logger.info << "Loading the physics tree from file: started" << logger.end;
+    try {
+        Serialization::Deserialize(root, &isf);
+    } catch (...) {
+        logger.warning << "Physics cache " << GetFileName()
+                       << " is damaged" << logger.end;
+        return false;
+    }
+    return true;
+}
+
+// The tree is written to a temporary file that is renamed into place
+// when complete, so an interrupted save never leaves a valid header in
+// front of a partial tree.
+bool PhysicsCache::Save(const ISceneNode& root) {
+    string file = GetFileName();
+    string temp = file + ".tmp";
+    ofstream of(temp.c_str(), ios::binary);
+    if (!of.is_open()) {
+        logger.warning << "Can not write physics cache "
+                       << file << logger.end;
+        return false;
+    }
+    unsigned int version = VERSION;
+    boost::uint64_t fileKey = key.Get();
+    of.write(MAGIC, sizeof(MAGIC));
+    of.write((const char*)&version, sizeof(version));
+    of.write((const char*)&fileKey, sizeof(fileKey));
+    Serialization::Serialize(root, &of);
+    of.close();
+    if (!of.good()) {
+        remove(temp.c_str());
+        return false;
+    }
+    // rename does not replace an existing file everywhere
+    remove(file.c_str());
+    if (rename(temp.c_str(), file.c_str()) != 0) {
+        logger.warning << "Can not write physics cache "
+                       << file << logger.end;
+        remove(temp.c_str());
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,66 @@
+// Validated cache for the serialized physics tree.
+// -------------------------------------------------------------------
+// Copyright (C) 2007 OpenEngine.dk (See AUTHORS)
+//
+// This program is free software; It is covered by the GNU General
+// Public License version 2 or any later version.
+// See the GNU General Public License for more details (see LICENSE).
+//--------------------------------------------------------------------
+
+#ifndef _PHYSICS_CACHE_
+#define _PHYSICS_CACHE_
+
+#include "ContentKey.h"
+
+#include <Scene/ISceneNode.h>
+
+using OpenEngine::Scene::ISceneNode;
+using std::string;
+
+/**
+ * Settings for the transformers building the physics tree.
+ * A value of zero leaves the transformer default untouched.
+ */
+struct PhysicsTreeSettings {
+    unsigned int quadMaxFaceCount;
+    unsigned int quadMaxQuadSize;
+    PhysicsTreeSettings()
+        : quadMaxFaceCount(0)
+        , quadMaxQuadSize(0)
+    {}
+};
+
+/**
+ * Content addressed cache of the transformed physics tree.
+ *
+ * The cache key is a ContentKey of the source geometry files, the
+ * transformer settings and the cache format version. The key is
+ * part of the file name and is repeated in a versioned header in
+ * front of the serialized tree, so a cache written for other
+ * geometry or settings is never loaded and is rebuilt instead.
+ *
+ * The tree itself is still stored with the engine serialization,
+ * as the physics engine consumes a scene node tree.
+ */
+class PhysicsCache {
+private:
+    static const unsigned int VERSION = 1;
+
+    string directory;
+    ContentKey key;
+
+public:
+    PhysicsCache(string directory);
+
+    void AddSource(string file);
+    void AddParameter(string name, unsigned int value);
+    void AddSettings(const PhysicsTreeSettings& settings);
+
+    boost::uint64_t GetKey() const;
+    string GetFileName() const;
+
+    bool Load(ISceneNode& root);
+    bool Save(const ISceneNode& root);
+};
+
+#endif
@@ -0,0 +1,154 @@
+#include "PhysicsCommand.h"
+
+#include <Logging/Logger.h>
+#include <Math/Matrix.h>
+
+using OpenEngine::Core::InitializeEventArg;
+using OpenEngine::Math::Matrix;
+
+namespace {
+PhysicsCommand Make(PhysicsCommand::Type type) {
+    PhysicsCommand cmd;
+    cmd.type = type;
+    cmd.up = cmd.down = cmd.left = cmd.right = cmd.delta = 0;
+    cmd.scale = 1;
+    cmd.ticks = 0;
+    return cmd;
+}
+}
+
+PhysicsCommand PhysicsCommand::Controls(float up, float down,
+                                        float left, float right, float delta) {
+    PhysicsCommand cmd = Make(CONTROLS);
+    cmd.up = up; cmd.down = down;
+    cmd.left = left; cmd.right = right;
+    cmd.delta = delta;
+    return cmd;
+}
+
+PhysicsCommand PhysicsCommand::Reset() {
+    return Make(RESET);
+}
+
+PhysicsCommand PhysicsCommand::Pause() {
+    return Make(PAUSE);
+}
+
+PhysicsCommand PhysicsCommand::Impulse(Vector<3,float> force) {
+    PhysicsCommand cmd = Make(IMPULSE);
+    cmd.force = force;
+    return cmd;
+}
+
+PhysicsCommand PhysicsCommand::Gravity(float scale) {
+    PhysicsCommand cmd = Make(GRAVITY);
+    cmd.scale = scale;
+    return cmd;
+}
+
+PhysicsCommand PhysicsCommand::Rewind(unsigned int ticks) {
+    PhysicsCommand cmd = Make(REWIND);
+    cmd.ticks = ticks;
+    return cmd;
+}
+
+PhysicsCommandResult ApplyPhysicsCommand(const PhysicsCommand& cmd,
+                                         FixedTimeStepPhysics* physics,
+                                         RigidBox* box,
+                                         PhysicsSnapshots* snapshots) {
+    PhysicsCommandResult result;
+    result.type = cmd.type;
+    result.done = false;
+    result.ticks = cmd.ticks;
+    switch (cmd.type) {
+    case PhysicsCommand::CONTROLS: {
+        if (box == NULL) return result;
+        static float speed = 1750.0f;
+        static float turn = 550.0f;
+        Matrix<3,3,float> m(box->GetRotationMatrix());
+
+        // Forward
+        if( cmd.up ){
+            Vector<3,float> dir = m.GetRow(0) * cmd.delta;
+            box->AddForce(dir * speed*cmd.up, 1);
+            box->AddForce(dir * speed*cmd.up, 2);
+            box->AddForce(dir * speed*cmd.up, 3);
+            box->AddForce(dir * speed*cmd.up, 4);
+        }
+        if( cmd.down ){
+            Vector<3,float> dir = -m.GetRow(0) * cmd.delta;
+            box->AddForce(dir * speed*cmd.down, 5);
+            box->AddForce(dir * speed*cmd.down, 6);
+            box->AddForce(dir * speed*cmd.down, 7);
+            box->AddForce(dir * speed*cmd.down, 8);
+        }
+        if( cmd.left ){
+            Vector<3,float> dir = -m.GetRow(2) * cmd.delta;
+            box->AddForce(dir * turn*cmd.left, 2);
+            box->AddForce(dir * turn*cmd.left, 4);
+        }
+        if( cmd.right ) {
+            Vector<3,float> dir = m.GetRow(2) * cmd.delta;
+            box->AddForce(dir * turn*cmd.right, 1);
+            box->AddForce(dir * turn*cmd.right, 3);
+        }
+        result.done = true;
+        break;
+    }
+    case PhysicsCommand::RESET:
+        if (snapshots != NULL) {
+            snapshots->RestoreInitial();
+            result.done = true;
+            return result;
+        }
+        if (physics == NULL) return result;
+        physics->Handle(InitializeEventArg());
+        if (box != NULL) {
+            box->ResetForces();
+            box->SetCenter( Vector<3,float>(2, 1, 2) );
+            result.done = true;
+        }
+        break;
+    case PhysicsCommand::PAUSE:
+        if (physics != NULL) physics->TogglePause();
+        result.done = physics != NULL;
+        break;
+    case PhysicsCommand::IMPULSE:
+        if (box != NULL) box->AddForce(cmd.force);
+        result.done = box != NULL;
+        break;
+    case PhysicsCommand::GRAVITY:
+        if (box != NULL) {
+            result.gravity = box->GetGravity();
+            box->SetGravity(result.gravity*cmd.scale);
+            result.done = true;
+        }
+        break;
+    case PhysicsCommand::REWIND:
+        result.done = snapshots != NULL && snapshots->Restore(cmd.ticks);
+        break;
+    }
+    return result;
+}
+
+void LogPhysicsCommand(const PhysicsCommandResult& result) {
+    switch (result.type) {
+    case PhysicsCommand::RESET:
+        if (result.done)
+            logger.info << "Reset Physics" << logger.end;
+        break;
+    case PhysicsCommand::GRAVITY:
+        if (result.done)
+            logger.info << "Gravity " << result.gravity << logger.end;
+        break;
+    case PhysicsCommand::REWIND:
+        if (result.done)
+            logger.info << "Rewound " << result.ticks << " ticks" << logger.end;
+        else
+            logger.warning << "Can not rewind " << result.ticks
+                           << " ticks" << logger.end;
+        break;
+    default:
+        break;
+    }
+}
@@ -0,0 +1,81 @@
+// Commands from the input handlers to the physics.
+// -------------------------------------------------------------------
+// Copyright (C) 2007 OpenEngine.dk (See AUTHORS)
+//
+// This program is free software; It is covered by the GNU General
+// Public License version 2 or any later version.
+// See the GNU General Public License for more details (see LICENSE).
+//--------------------------------------------------------------------
+
+#ifndef _PHYSICS_COMMAND_
+#define _PHYSICS_COMMAND_
+
+#include <Physics/FixedTimeStepPhysics.h>
+#include <Physics/RigidBox.h>
+#include <Math/Vector.h>
+
+#include "LockFree.h"
+#include "PhysicsSnapshots.h"
+
+using OpenEngine::Physics::FixedTimeStepPhysics;
+using OpenEngine::Physics::RigidBox;
+using OpenEngine::Math::Vector;
+
+/**
+ * A change to the simulated vehicle requested by the input handlers.
+ *
+ * CONTROLS applies the driving forces for the control values scaled
+ * by delta, RESET re-initializes the physics and puts the vehicle
+ * back at the start, PAUSE toggles the physics, IMPULSE adds the
+ * given force to the vehicle, GRAVITY scales its gravity and REWIND
+ * moves the bodies back the given number of ticks.
+ */
+struct PhysicsCommand {
+    enum Type { CONTROLS, RESET, PAUSE, IMPULSE, GRAVITY, REWIND };
+    Type type;
+    float up, down, left, right, delta;
+    float scale;
+    Vector<3,float> force;
+    unsigned int ticks;
+
+    static PhysicsCommand Controls(float up, float down,
+                                   float left, float right, float delta);
+    static PhysicsCommand Reset();
+    static PhysicsCommand Pause();
+    static PhysicsCommand Impulse(Vector<3,float> force);
+    static PhysicsCommand Gravity(float scale);
+    static PhysicsCommand Rewind(unsigned int ticks);
+};
+
+typedef LockFreeQueue<PhysicsCommand, 256> PhysicsCommandQueue;
+
+/**
+ * What executing a command did, for the log. Gravity is the vehicle
+ * gravity before a GRAVITY command.
+ */
+struct PhysicsCommandResult {
+    PhysicsCommand::Type type;
+    bool done;
+    unsigned int ticks;
+    Vector<3,float> gravity;
+};
+
+typedef LockFreeQueue<PhysicsCommandResult, 64> PhysicsResultQueue;
+
+/**
+ * Executes a command on the physics and the vehicle. Must be called
+ * from the thread that steps the physics. With snapshots a reset
+ * restores the initial snapshot instead of re-initializing the
+ * physics, and rewinding needs them.
+ *
+ * Nothing is logged, as the physics may run on its own thread. The
+ * result is logged with LogPhysicsCommand on the engine thread.
+ */
+PhysicsCommandResult ApplyPhysicsCommand(const PhysicsCommand& cmd,
+                                         FixedTimeStepPhysics* physics,
+                                         RigidBox* box,
+                                         PhysicsSnapshots* snapshots = NULL);
+
+void LogPhysicsCommand(const PhysicsCommandResult& result);
+
+#endif
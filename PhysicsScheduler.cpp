@@ -0,0 +1,117 @@
+#include "PhysicsScheduler.h"
+
+#include "PhysicsCommand.h"
+
+#include <Logging/Logger.h>
+
+PhysicsScheduler::PhysicsScheduler(FixedTimeStepPhysics& physics,
+                                   unsigned int rate,
+                                   unsigned int maxSubsteps)
+    : physics(physics)
+    , input(NULL)
+    , box(NULL)
+    , snapshots(NULL)
+    , stepTime(MAX_STEP_TIME)
+    , maxSubsteps(1)
+    , accumulator(0)
+    , accumulated(0)
+    , dropped(0)
+    , steps(0)
+    , dilatedFrames(0)
+{
+    if (rate != 0) SetStepTime(1000000 / rate);
+    SetMaxSubsteps(maxSubsteps);
+}
+
+void PhysicsScheduler::Handle(InitializeEventArg arg) {
+    timer.Start();
+}
+
+void PhysicsScheduler::Handle(ProcessEventArg arg) {
+    unsigned int elapsed = timer.GetElapsedTimeAndReset().AsInt();
+    accumulator += elapsed;
+    accumulated += elapsed;
+
+    // Each step ends accumulator usec before the input clock now
+    unsigned int now = input != NULL ? input->GetClock() : 0;
+    unsigned int substeps = 0;
+    while (accumulator >= stepTime && substeps < maxSubsteps) {
+        accumulator -= stepTime;
+        if (input != NULL) {
+            ControlState c;
+            input->Coalesce(now > accumulator ? now - accumulator : 0, c);
+            ApplyPhysicsCommand(PhysicsCommand::Controls(c.up, c.down,
+                                                         c.left, c.right,
+                                                         stepTime / 100000.0f),
+                                &physics, box);
+        }
+        physics.Handle(ProcessEventArg(Timer::GetTime(), stepTime));
+        if (snapshots != NULL) snapshots->Capture();
+        substeps++;
+    }
+    steps += substeps;
+
+    // Over budget, keep less than a step and let the rest go
+    if (accumulator >= stepTime) {
+        unsigned int keep = accumulator % stepTime;
+        dropped += accumulator - keep;
+        accumulator = keep;
+        dilatedFrames++;
+    }
+}
+
+void PhysicsScheduler::Handle(DeinitializeEventArg arg) {
+    logger.info << "Physics scheduler: " << steps << " steps of "
+                << stepTime << " usec, " << dropped / 1000 << " of "
+                << accumulated / 1000 << " ms dropped in "
+                << dilatedFrames << " frames" << logger.end;
+}
+
+void PhysicsScheduler::SetStepTime(unsigned int usec) {
+    if (usec < MIN_STEP_TIME) usec = MIN_STEP_TIME;
+    if (usec > MAX_STEP_TIME) usec = MAX_STEP_TIME;
+    stepTime = usec;
+}
+
+void PhysicsScheduler::AdjustStepTime(int usec) {
+    int time = (int)stepTime + usec;
+    SetStepTime(time < 0 ? 0 : time);
+}
+
+void PhysicsScheduler::SetMaxSubsteps(unsigned int substeps) {
+    maxSubsteps = substeps != 0 ? substeps : 1;
+}
+
+// Take the vehicle controls for box from the input queue.
+void PhysicsScheduler::SetInputQueue(InputQueue* input, RigidBox* box) {
+    this->input = input;
+    this->box = box;
+}
+
+void PhysicsScheduler::SetSnapshots(PhysicsSnapshots* snapshots) {
+    this->snapshots = snapshots;
+}
+
+unsigned int PhysicsScheduler::GetStepTime() const {
+    return stepTime;
+}
+
+unsigned int PhysicsScheduler::GetMaxSubsteps() const {
+    return maxSubsteps;
+}
+
+unsigned int PhysicsScheduler::GetStepCount() const {
+    return steps;
+}
+
+unsigned int PhysicsScheduler::GetDilatedFrames() const {
+    return dilatedFrames;
+}
+
+unsigned long long PhysicsScheduler::GetAccumulatedTime() const {
+    return accumulated;
+}
+
+unsigned long long PhysicsScheduler::GetDroppedTime() const {
+    return dropped;
+}
@@ -0,0 +1,85 @@
+// Fixed step physics scheduling with a substep budget.
+// -------------------------------------------------------------------
+// Copyright (C) 2007 OpenEngine.dk (See AUTHORS)
+//
+// This program is free software; It is covered by the GNU General
+// Public License version 2 or any later version.
+// See the GNU General Public License for more details (see LICENSE).
+//--------------------------------------------------------------------
+
+#ifndef _PHYSICS_SCHEDULER_
+#define _PHYSICS_SCHEDULER_
+
+#include <Core/IModule.h>
+#include <Physics/FixedTimeStepPhysics.h>
+#include <Utils/Timer.h>
+
+#include "InputQueue.h"
+#include "PhysicsSnapshots.h"
+
+using OpenEngine::Core::IModule;
+using OpenEngine::Core::InitializeEventArg;
+using OpenEngine::Core::ProcessEventArg;
+using OpenEngine::Core::DeinitializeEventArg;
+using OpenEngine::Physics::FixedTimeStepPhysics;
+using OpenEngine::Physics::RigidBox;
+using OpenEngine::Utils::Timer;
+
+/**
+ * Steps the physics on the engine thread at a fixed rate, replacing
+ * FixedTimeStepPhysicsTimer.
+ *
+ * The frame time is added to an accumulator and the physics is
+ * stepped once for every whole step time in it, but at most
+ * maxSubsteps times per frame. Whatever is left beyond one step after
+ * that is dropped, so after a slow frame the simulation runs slower
+ * than the wall clock for a moment instead of the physics making the
+ * following frames slower still. The step time can be changed while
+ * running, and the total accumulated and dropped time is counted.
+ *
+ * With an input queue the vehicle controls are applied before every
+ * step, averaged over the wall clock time the step stands for. With
+ * snapshots the bodies are captured after every step.
+ */
+class PhysicsScheduler : public IModule {
+private:
+    FixedTimeStepPhysics& physics;
+    InputQueue* input;
+    RigidBox* box;
+    PhysicsSnapshots* snapshots;
+    unsigned int stepTime;        // usec
+    unsigned int maxSubsteps;
+    unsigned int accumulator;     // usec not yet simulated
+    unsigned long long accumulated;
+    unsigned long long dropped;
+    unsigned int steps;
+    unsigned int dilatedFrames;
+    Timer timer;
+
+public:
+    static const unsigned int MIN_STEP_TIME = 1000;
+    static const unsigned int MAX_STEP_TIME = 100000;
+
+    PhysicsScheduler(FixedTimeStepPhysics& physics,
+                     unsigned int rate = 100,
+                     unsigned int maxSubsteps = 5);
+
+    void Handle(InitializeEventArg arg);
+    void Handle(ProcessEventArg arg);
+    void Handle(DeinitializeEventArg arg);
+
+    void SetStepTime(unsigned int usec);
+    void AdjustStepTime(int usec);
+    void SetMaxSubsteps(unsigned int substeps);
+    void SetInputQueue(InputQueue* input, RigidBox* box);
+    void SetSnapshots(PhysicsSnapshots* snapshots);
+
+    unsigned int GetStepTime() const;
+    unsigned int GetMaxSubsteps() const;
+    unsigned int GetStepCount() const;
+    unsigned int GetDilatedFrames() const;
+    unsigned long long GetAccumulatedTime() const;
+    unsigned long long GetDroppedTime() const;
+};
+
+#endif
@@ -0,0 +1,86 @@
+#include "PhysicsSnapshots.h"
+
+PhysicsSnapshots::PhysicsSnapshots(unsigned int capacity)
+    : capacity(capacity)
+    , next(0)
+    , count(0)
+    , captures(0)
+{}
+
+// Adding a body drops the snapshots taken so far.
+void PhysicsSnapshots::Add(RigidBox* body) {
+    bodies.push_back(body);
+    ring.resize(capacity * bodies.size());
+    initial.resize(bodies.size());
+    next = count = 0;
+}
+
+void PhysicsSnapshots::Save(BodyState* states) {
+    for (unsigned int i = 0; i < bodies.size(); i++) {
+        RigidBox* b = bodies[i];
+        states[i].center   = b->GetCenter();
+        states[i].rotation = b->GetRotation();
+        states[i].linear   = b->GetLinearVelocity();
+        states[i].angular  = b->GetAngularVelocity();
+        states[i].gravity  = b->GetGravity();
+    }
+}
+
+void PhysicsSnapshots::Load(const BodyState* states) {
+    for (unsigned int i = 0; i < bodies.size(); i++) {
+        RigidBox* b = bodies[i];
+        b->ResetForces();
+        b->SetCenter(states[i].center);
+        b->SetRotation(states[i].rotation);
+        b->SetLinearVelocity(states[i].linear);
+        b->SetAngularVelocity(states[i].angular);
+        b->SetGravity(states[i].gravity);
+    }
+}
+
+// Keeps the current state as the one RestoreInitial returns to.
+void PhysicsSnapshots::SetInitial() {
+    if (bodies.empty()) return;
+    Save(&initial[0]);
+}
+
+void PhysicsSnapshots::Capture() {
+    if (bodies.empty()) return;
+    Save(&ring[next * bodies.size()]);
+    next = (next + 1) % capacity;
+    if (count < capacity) count++;
+    captures++;
+}
+
+// Puts the bodies back to their state ticks captures ago, 0 being
+// the latest. Fails if the ring does not reach that far back.
+bool PhysicsSnapshots::Restore(unsigned int ticks) {
+    if (ticks >= count) return false;
+    unsigned int slot = (next + capacity - 1 - ticks) % capacity;
+    Load(&ring[slot * bodies.size()]);
+    next = (slot + 1) % capacity;
+    count -= ticks;
+    return true;
+}
+
+void PhysicsSnapshots::RestoreInitial() {
+    if (bodies.empty()) return;
+    Load(&initial[0]);
+    next = count = 0;
+}
+
+unsigned int PhysicsSnapshots::GetCapacity() const {
+    return capacity;
+}
+
+unsigned int PhysicsSnapshots::GetCount() const {
+    return count;
+}
+
+unsigned int PhysicsSnapshots::GetCaptureCount() const {
+    return captures;
+}
+
+void PhysicsSnapshots::Handle(ProcessEventArg arg) {
+    Capture();
+}
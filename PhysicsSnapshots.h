@@ -0,0 +1,84 @@
+// Ring buffer of rigid body snapshots.
+// -------------------------------------------------------------------
+// Copyright (C) 2007 OpenEngine.dk (See AUTHORS)
+//
+// This program is free software; It is covered by the GNU General
+// Public License version 2 or any later version.
+// See the GNU General Public License for more details (see LICENSE).
+//--------------------------------------------------------------------
+
+#ifndef _PHYSICS_SNAPSHOTS_
+#define _PHYSICS_SNAPSHOTS_
+
+#include <Core/IListener.h>
+#include <Core/EngineEvents.h>
+#include <Math/Quaternion.h>
+#include <Math/Vector.h>
+#include <Physics/RigidBox.h>
+
+#include <vector>
+
+using OpenEngine::Core::IListener;
+using OpenEngine::Core::ProcessEventArg;
+using OpenEngine::Math::Quaternion;
+using OpenEngine::Math::Vector;
+using OpenEngine::Physics::RigidBox;
+using std::vector;
+
+/**
+ * Snapshots of the state of a set of rigid bodies after each physics
+ * step, kept in a ring buffer of a fixed number of ticks.
+ *
+ * A snapshot is the center, rotation, linear and angular velocity
+ * and gravity of every body, 64 bytes per body. The ring is
+ * allocated when the bodies are added, so Capture only copies the
+ * state into the next slot. Restore rewinds the bodies a number of
+ * ticks and forgets the snapshots after it, so rewinding again goes
+ * further back. One extra snapshot is kept apart as the initial
+ * state, which is what a reset restores.
+ *
+ * Forces are accumulated between steps and cleared by them, so they
+ * are not part of the state after a step; restoring clears them.
+ *
+ * As a process listener attached after the physics it captures once
+ * per tick.
+ */
+class PhysicsSnapshots : public IListener<ProcessEventArg> {
+private:
+    struct BodyState {
+        Vector<3,float> center;
+        Vector<3,float> linear;
+        Vector<3,float> angular;
+        Vector<3,float> gravity;
+        Quaternion<float> rotation;
+    };
+
+    vector<RigidBox*> bodies;
+    vector<BodyState> ring;       // capacity snapshots of all bodies
+    vector<BodyState> initial;
+    unsigned int capacity;
+    unsigned int next;            // slot of the next capture
+    unsigned int count;           // snapshots in the ring
+    unsigned int captures;
+
+    void Save(BodyState* states);
+    void Load(const BodyState* states);
+
+public:
+    PhysicsSnapshots(unsigned int capacity = 512);
+
+    void Add(RigidBox* body);
+    void SetInitial();
+
+    void Capture();
+    bool Restore(unsigned int ticks);
+    void RestoreInitial();
+
+    unsigned int GetCapacity() const;
+    unsigned int GetCount() const;
+    unsigned int GetCaptureCount() const;
+
+    void Handle(ProcessEventArg arg);
+};
+
+#endif
@@ -0,0 +1,131 @@
+#include "PhysicsThread.h"
+#include "PhysicsScheduler.h"
+
+#include <Logging/Logger.h>
+
+namespace {
+// Steps to fall behind before the thread gives up catching up
+const unsigned int MAX_LAG_STEPS = 5;
+
+// The step time of a rate within the bounds the scheduler allows
+unsigned int StepTime(unsigned int rate) {
+    if (rate == 0) return PhysicsScheduler::MAX_STEP_TIME;
+    unsigned int usec = 1000000 / rate;
+    if (usec < PhysicsScheduler::MIN_STEP_TIME)
+        return PhysicsScheduler::MIN_STEP_TIME;
+    if (usec > PhysicsScheduler::MAX_STEP_TIME)
+        return PhysicsScheduler::MAX_STEP_TIME;
+    return usec;
+}
+}
+
+PhysicsThread::PhysicsThread(FixedTimeStepPhysics& physics,
+                             RigidBox* box,
+                             PhysicsCommandQueue& commands,
+                             unsigned int rate)
+    : physics(physics)
+    , box(box)
+    , commands(commands)
+    , input(NULL)
+    , snapshots(NULL)
+    , stepTime(StepTime(rate))
+    , running(false)
+    , steps(0)
+{}
+
+void PhysicsThread::Publish() {
+    VehiclePose pose;
+    pose.time = GetClock();
+    pose.position = box->GetCenter();
+    pose.rotation = Quaternion<float>(box->GetRotationMatrix());
+
+    PoseSnapshot& snapshot = poses.Back();
+    snapshot.previous = steps > 1 ? last : pose;
+    snapshot.current = pose;
+    poses.Publish();
+    last = pose;
+}
+
+void PhysicsThread::SetInputQueue(InputQueue* input) {
+    this->input = input;
+}
+
+void PhysicsThread::SetSnapshots(PhysicsSnapshots* snapshots) {
+    this->snapshots = snapshots;
+}
+
+void PhysicsThread::Run() {
+    physics.Handle(InitializeEventArg());
+    unsigned int next = GetClock();
+    while (running) {
+        PhysicsCommand cmd;
+        while (commands.Pop(cmd)) {
+            PhysicsCommandResult result =
+                ApplyPhysicsCommand(cmd, &physics, box, snapshots);
+            if (cmd.type != PhysicsCommand::CONTROLS)
+                results.Push(result);
+        }
+        if (input != NULL) {
+            ControlState c;
+            input->Coalesce(input->GetClock(), c);
+            ApplyPhysicsCommand(PhysicsCommand::Controls(c.up, c.down,
+                                                         c.left, c.right,
+                                                         stepTime / 100000.0f),
+                                &physics, box);
+        }
+
+        physics.Handle(ProcessEventArg(Timer::GetTime(), stepTime));
+        if (snapshots != NULL) snapshots->Capture();
+        ++steps;
+        if (box != NULL) Publish();
+
+        next += stepTime;
+        unsigned int now = GetClock();
+        if (now < next)
+            Thread::Sleep(next - now);
+        else if (now - next > MAX_LAG_STEPS * stepTime)
+            next = now;
+    }
+    physics.Handle(DeinitializeEventArg());
+}
+
+void PhysicsThread::Handle(InitializeEventArg arg) {
+    timer.Start();
+    running = true;
+    Start();
+}
+
+// Log the command results passed back by the physics thread. Called
+// on the engine thread only.
+void PhysicsThread::LogResults() {
+    PhysicsCommandResult result;
+    while (results.Pop(result))
+        LogPhysicsCommand(result);
+}
+
+void PhysicsThread::Handle(ProcessEventArg arg) {
+    LogResults();
+}
+
+void PhysicsThread::Handle(DeinitializeEventArg arg) {
+    running = false;
+    Wait();
+    LogResults();
+    logger.info << "Physics thread ran " << steps << " steps" << logger.end;
+}
+
+unsigned int PhysicsThread::GetClock() {
+    return timer.GetElapsedTime().AsInt();
+}
+
+unsigned int PhysicsThread::GetStepTime() const {
+    return stepTime;
+}
+
+unsigned int PhysicsThread::GetStepCount() const {
+    return steps;
+}
+
+TripleBuffer<PoseSnapshot>& PhysicsThread::GetPoses() {
+    return poses;
+}
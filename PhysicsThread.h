@@ -0,0 +1,101 @@
+// Physics running on its own thread.
+// -------------------------------------------------------------------
+// Copyright (C) 2007 OpenEngine.dk (See AUTHORS)
+//
+// This program is free software; It is covered by the GNU General
+// Public License version 2 or any later version.
+// See the GNU General Public License for more details (see LICENSE).
+//--------------------------------------------------------------------
+
+#ifndef _PHYSICS_THREAD_
+#define _PHYSICS_THREAD_
+
+#include <Core/IModule.h>
+#include <Core/Thread.h>
+#include <Math/Quaternion.h>
+#include <Utils/Timer.h>
+
+#include "LockFree.h"
+#include "PhysicsCommand.h"
+#include "InputQueue.h"
+
+using OpenEngine::Core::IModule;
+using OpenEngine::Core::Thread;
+using OpenEngine::Core::InitializeEventArg;
+using OpenEngine::Core::ProcessEventArg;
+using OpenEngine::Core::DeinitializeEventArg;
+using OpenEngine::Math::Quaternion;
+using OpenEngine::Utils::Timer;
+
+/**
+ * Pose of the vehicle after a physics step, with the time of the
+ * step on the physics thread clock.
+ */
+struct VehiclePose {
+    unsigned int time;
+    Vector<3,float> position;
+    Quaternion<float> rotation;
+};
+
+/**
+ * The two latest poses, published together so the reader can
+ * interpolate between them.
+ */
+struct PoseSnapshot {
+    VehiclePose previous;
+    VehiclePose current;
+};
+
+/**
+ * Steps the physics on a dedicated thread at a fixed rate.
+ *
+ * The physics is owned by the thread from initialize to deinitialize:
+ * input arrives only through the command queue, which is drained
+ * before every step, and the vehicle pose is published after every
+ * step through a triple buffer. Neither side ever waits for the
+ * other. When the thread falls more than a few steps behind it skips
+ * ahead instead of trying to catch up. The results of the commands
+ * are passed back through a second queue and logged on the engine
+ * thread, as the logger is not thread safe. With an input queue the
+ * vehicle controls are coalesced from it before every step, and
+ * with snapshots the bodies are captured after every step.
+ */
+class PhysicsThread : public Thread, public IModule {
+private:
+    FixedTimeStepPhysics& physics;
+    RigidBox* box;
+    PhysicsCommandQueue& commands;
+    PhysicsResultQueue results;
+    InputQueue* input;
+    PhysicsSnapshots* snapshots;
+    unsigned int stepTime;
+    TripleBuffer<PoseSnapshot> poses;
+    VehiclePose last;
+    volatile bool running;
+    volatile unsigned int steps;
+    Timer timer;
+
+    void Publish();
+    void LogResults();
+
+public:
+    PhysicsThread(FixedTimeStepPhysics& physics,
+                  RigidBox* box,
+                  PhysicsCommandQueue& commands,
+                  unsigned int rate);
+
+    void SetInputQueue(InputQueue* input);
+    void SetSnapshots(PhysicsSnapshots* snapshots);
+    void Run();
+
+    void Handle(InitializeEventArg arg);
+    void Handle(ProcessEventArg arg);
+    void Handle(DeinitializeEventArg arg);
+
+    unsigned int GetClock();
+    unsigned int GetStepTime() const;
+    unsigned int GetStepCount() const;
+    TripleBuffer<PoseSnapshot>& GetPoses();
+};
+
+#endif
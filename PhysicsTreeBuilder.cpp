@@ -0,0 +1,162 @@
+#include "PhysicsTreeBuilder.h"
+
+#include <Core/Mutex.h>
+#include <Core/Thread.h>
+#include <Geometry/FaceSet.h>
+#include <Scene/BSPTransformer.h>
+#include <Scene/CollectedGeometryTransformer.h>
+#include <Scene/GeometryNode.h>
+#include <Scene/QuadTransformer.h>
+#include <Utils/Timer.h>
+
+#include <algorithm>
+#include <vector>
+
+using OpenEngine::Core::Mutex;
+using OpenEngine::Core::Thread;
+using OpenEngine::Geometry::FaceSet;
+using OpenEngine::Scene::BSPTransformer;
+using OpenEngine::Scene::CollectedGeometryTransformer;
+using OpenEngine::Scene::GeometryNode;
+using OpenEngine::Scene::QuadTransformer;
+using OpenEngine::Utils::Timer;
+using std::vector;
+
+namespace {
+
+// A subtree for the BSP transformer and the faces below it
+struct BSPJob {
+    ISceneNode* node;
+    unsigned int faces;
+    bool operator<(const BSPJob& other) const {
+        return faces > other.faces;
+    }
+};
+
+unsigned int CountFaces(ISceneNode* node) {
+    unsigned int faces = 0;
+    GeometryNode* geom = dynamic_cast<GeometryNode*>(node);
+    if (geom != NULL && geom->GetFaceSet() != NULL)
+        faces += geom->GetFaceSet()->Size();
+    for (unsigned int i = 0; i < node->GetNumberOfNodes(); i++)
+        faces += CountFaces(node->GetNode(i));
+    return faces;
+}
+
+// The topmost nodes with geometry directly below them. The BSP
+// transformer replaces geometry nodes in their parents, so these are
+// the smallest subtrees that can be transformed on their own.
+void CollectJobs(ISceneNode* node, vector<BSPJob>& jobs) {
+    for (unsigned int i = 0; i < node->GetNumberOfNodes(); i++)
+        if (dynamic_cast<GeometryNode*>(node->GetNode(i)) != NULL) {
+            BSPJob job;
+            job.node = node;
+            job.faces = CountFaces(node);
+            jobs.push_back(job);
+            return;
+        }
+    for (unsigned int i = 0; i < node->GetNumberOfNodes(); i++)
+        CollectJobs(node->GetNode(i), jobs);
+}
+
+struct BSPJobs {
+    vector<BSPJob>& jobs;
+    unsigned int next;
+    Mutex lock;
+    BSPJobs(vector<BSPJob>& jobs) : jobs(jobs), next(0) {}
+};
+
+class BSPWorker : public Thread {
+private:
+    BSPJobs& jobs;
+public:
+    BSPWorker(BSPJobs& jobs) : jobs(jobs) {}
+    void Run() {
+        BSPTransformer bspT;
+        for (;;) {
+            jobs.lock.Lock();
+            unsigned int job = jobs.next++;
+            jobs.lock.Unlock();
+            if (job >= jobs.jobs.size()) return;
+            bspT.Transform(*jobs.jobs[job].node);
+        }
+    }
+};
+
+} // anonymous namespace
+
+PhysicsTreeBuilder::PhysicsTreeBuilder(const PhysicsTreeSettings& settings,
+                                       unsigned int threads)
+    : settings(settings)
+    , threads(threads)
+    , collectTime(0)
+    , quadTime(0)
+    , bspTime(0)
+    , jobs(0)
+{}
+
+void PhysicsTreeBuilder::Build(ISceneNode& root) {
+    CollectedGeometryTransformer collT;
+    QuadTransformer quadT;
+    if (settings.quadMaxFaceCount != 0)
+        quadT.SetMaxFaceCount(settings.quadMaxFaceCount);
+    if (settings.quadMaxQuadSize != 0)
+        quadT.SetMaxQuadSize(settings.quadMaxQuadSize);
+
+    Timer timer;
+    timer.Start();
+    collT.Transform(root);
+    collectTime = timer.GetElapsedTimeAndReset().AsInt();
+    quadT.Transform(root);
+    quadTime = timer.GetElapsedTimeAndReset().AsInt();
+    if (threads == 0) {
+        BSPTransformer bspT;
+        bspT.Transform(root);
+        jobs = 1;
+    } else
+        TransformQuads(root);
+    bspTime = timer.GetElapsedTime().AsInt();
+}
+
+void PhysicsTreeBuilder::TransformQuads(ISceneNode& root) {
+    vector<BSPJob> work;
+    CollectJobs(&root, work);
+    std::stable_sort(work.begin(), work.end());
+    jobs = work.size();
+
+    BSPJobs shared(work);
+    unsigned int count = std::min(threads, jobs);
+    vector<BSPWorker*> workers;
+    for (unsigned int i = 0; i < count; i++) {
+        workers.push_back(new BSPWorker(shared));
+        workers.back()->Start();
+    }
+    for (unsigned int i = 0; i < workers.size(); i++) {
+        workers[i]->Wait();
+        delete workers[i];
+    }
+}
+
+unsigned int PhysicsTreeBuilder::GetThreadCount() const {
+    return threads;
+}
+
+unsigned int PhysicsTreeBuilder::GetJobCount() const {
+    return jobs;
+}
+
+unsigned int PhysicsTreeBuilder::GetCollectTime() const {
+    return collectTime;
+}
+
+unsigned int PhysicsTreeBuilder::GetQuadTime() const {
+    return quadTime;
+}
+
+unsigned int PhysicsTreeBuilder::GetBSPTime() const {
+    return bspTime;
+}
+
+unsigned int PhysicsTreeBuilder::GetBuildTime() const {
+    return collectTime + quadTime + bspTime;
+}
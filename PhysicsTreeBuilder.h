@@ -0,0 +1,57 @@
+// Builder of the physics quad/BSP tree.
+// -------------------------------------------------------------------
+// Copyright (C) 2007 OpenEngine.dk (See AUTHORS)
+//
+// This program is free software; It is covered by the GNU General
+// Public License version 2 or any later version.
+// See the GNU General Public License for more details (see LICENSE).
+//--------------------------------------------------------------------
+
+#ifndef _PHYSICS_TREE_BUILDER_
+#define _PHYSICS_TREE_BUILDER_
+
+#include "PhysicsCache.h"
+
+#include <Scene/ISceneNode.h>
+
+using OpenEngine::Scene::ISceneNode;
+
+/**
+ * Transforms the physic scene into the hybrid quad/BSP tree used by
+ * the physics engine.
+ *
+ * The geometry is collected and split into quads on the calling
+ * thread. The BSP trees below the quads are independent of each
+ * other, so with worker threads every subtree holding geometry is
+ * handed to the next free worker, largest first. Each worker only
+ * changes the nodes of its own subtree, and a BSP tree depends on
+ * nothing but the faces of its quad, so the result is the same tree
+ * the serial build gives.
+ *
+ * With zero threads the whole tree is transformed serially, exactly
+ * as before.
+ */
+class PhysicsTreeBuilder {
+private:
+    PhysicsTreeSettings settings;
+    unsigned int threads;
+    unsigned int collectTime, quadTime, bspTime; // usec
+    unsigned int jobs;
+
+    void TransformQuads(ISceneNode& root);
+
+public:
+    PhysicsTreeBuilder(const PhysicsTreeSettings& settings,
+                       unsigned int threads = 0);
+
+    void Build(ISceneNode& root);
+
+    unsigned int GetThreadCount() const;
+    unsigned int GetJobCount() const;
+    unsigned int GetCollectTime() const;
+    unsigned int GetQuadTime() const;
+    unsigned int GetBSPTime() const;
+    unsigned int GetBuildTime() const;
+};
+
+#endif
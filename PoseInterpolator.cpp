@@ -0,0 +1,49 @@
+#include "PoseInterpolator.h"
+
+namespace {
+// Normalized linear interpolation along the shortest arc
+Quaternion<float> Nlerp(const Quaternion<float>& a,
+                        const Quaternion<float>& b,
+                        float t) {
+    float aw = a.GetReal(), bw = b.GetReal();
+    Vector<3,float> av = a.GetImaginary(), bv = b.GetImaginary();
+    if (aw * bw + av * bv < 0) {
+        bw = -bw;
+        bv = -bv;
+    }
+    Quaternion<float> q(aw + (bw - aw) * t, av + (bv - av) * t);
+    q.Normalize();
+    return q;
+}
+}
+
+PoseInterpolator::PoseInterpolator(PhysicsThread& thread,
+                                   TransformationNode* node)
+    : thread(thread)
+    , node(node)
+    , ready(false)
+{}
+
+void PoseInterpolator::Handle(InitializeEventArg arg) {}
+
+void PoseInterpolator::Handle(ProcessEventArg arg) {
+    TripleBuffer<PoseSnapshot>& poses = thread.GetPoses();
+    if (poses.Update()) ready = true;
+    if (!ready) return;
+    const PoseSnapshot& s = poses.Front();
+
+    float t = 1.0f;
+    unsigned int span = s.current.time - s.previous.time;
+    if (span > 0) {
+        // render one step behind the physics
+        float when = (float)thread.GetClock() - thread.GetStepTime();
+        t = (when - s.previous.time) / span;
+        if (t < 0.0f) t = 0.0f;
+        if (t > 1.0f) t = 1.0f;
+    }
+    node->SetPosition(s.previous.position +
+                      (s.current.position - s.previous.position) * t);
+    node->SetRotation(Nlerp(s.previous.rotation, s.current.rotation, t));
+}
+
+void PoseInterpolator::Handle(DeinitializeEventArg arg) {}
@@ -0,0 +1,41 @@
+// Interpolation of the vehicle pose published by the physics thread.
+// -------------------------------------------------------------------
+// Copyright (C) 2007 OpenEngine.dk (See AUTHORS)
+//
+// This program is free software; It is covered by the GNU General
+// Public License version 2 or any later version.
+// See the GNU General Public License for more details (see LICENSE).
+//--------------------------------------------------------------------
+
+#ifndef _POSE_INTERPOLATOR_
+#define _POSE_INTERPOLATOR_
+
+#include <Core/IModule.h>
+#include <Scene/TransformationNode.h>
+
+#include "PhysicsThread.h"
+
+using OpenEngine::Scene::TransformationNode;
+
+/**
+ * Moves the vehicle transformation node on the render thread.
+ *
+ * The node is placed where the vehicle was one physics step ago,
+ * interpolated between the two latest published poses, so the motion
+ * stays smooth when the frame rate and the physics rate differ.
+ */
+class PoseInterpolator : public IModule {
+private:
+    PhysicsThread& thread;
+    TransformationNode* node;
+    bool ready;
+
+public:
+    PoseInterpolator(PhysicsThread& thread, TransformationNode* node);
+
+    void Handle(InitializeEventArg arg);
+    void Handle(ProcessEventArg arg);
+    void Handle(DeinitializeEventArg arg);
+};
+
+#endif
@@ -0,0 +1,155 @@
+#include "QuadTuner.h"
+#include "SceneBounds.h"
+
+#include <Core/Exceptions.h>
+#include <Geometry/Face.h>
+#include <Logging/Logger.h>
+#include <Math/Math.h>
+#include <Scene/BSPTransformer.h>
+#include <Scene/CollectedGeometryTransformer.h>
+#include <Scene/QuadTransformer.h>
+#include <Scene/SceneNode.h>
+#include <Scene/TransformationNode.h>
+#include <Utils/Timer.h>
+
+#include <algorithm>
+
+using OpenEngine::Core::Exception;
+using OpenEngine::Geometry::Face;
+using OpenEngine::Geometry::FacePtr;
+using OpenEngine::Math::PI;
+using OpenEngine::Scene::BSPTransformer;
+using OpenEngine::Scene::CollectedGeometryTransformer;
+using OpenEngine::Scene::QuadTransformer;
+using OpenEngine::Scene::SceneNode;
+using OpenEngine::Scene::TransformationNode;
+using OpenEngine::Utils::Timer;
+
+QuadTuner::QuadTuner(string manifest, unsigned int threads)
+    : manifest(manifest)
+    , threads(threads)
+{}
+
+void QuadTuner::AddFaceCount(unsigned int count) {
+    faceCounts.push_back(count);
+}
+
+void QuadTuner::AddQuadSize(unsigned int size) {
+    quadSizes.push_back(size);
+}
+
+void QuadTuner::Run(ModelEntry::Section section) {
+    if (faceCounts.empty() || quadSizes.empty())
+        throw Exception("No quad tree parameters to tune.");
+    results.clear();
+    for (unsigned int f = 0; f < faceCounts.size(); f++)
+        for (unsigned int s = 0; s < quadSizes.size(); s++) {
+            QuadTuneResult r = Measure(section, faceCounts[f], quadSizes[s]);
+            logger.info << "Quad " << r.maxFaceCount << "/" << r.maxQuadSize
+                        << ": build " << r.buildTime / 1000 << " ms, "
+                        << r.nodes << " nodes (" << r.geometryNodes
+                        << " with geometry), " << r.faces << " faces, "
+                        << r.memory / 1024 << " kb, "
+                        << r.queryTime << " usec/query, "
+                        << r.candidates << " faces/query" << logger.end;
+            results.push_back(r);
+        }
+}
+
+QuadTuneResult QuadTuner::Measure(ModelEntry::Section section,
+                                  unsigned int maxFaceCount,
+                                  unsigned int maxQuadSize) {
+    ModelLoader loader(threads);
+    loader.ReadManifest(manifest);
+    loader.SelectSection(section);
+    loader.Load();
+
+    // Same layout as the scenes built by SetupScene
+    SceneNode* root = new SceneNode();
+    vector<ModelEntry>& entries = loader.GetEntries();
+    for (unsigned int i = 0; i < entries.size(); i++) {
+        if (entries[i].node == NULL) continue;
+        TransformationNode* tran = new TransformationNode();
+        tran->AddNode(entries[i].node);
+        root->AddNode(tran);
+    }
+
+    QuadTuneResult r;
+    r.maxFaceCount = maxFaceCount;
+    r.maxQuadSize = maxQuadSize;
+
+    // The physics tree is queried on the quad level, the BSP trees
+    // below it only add to the build time.
+    CollectedGeometryTransformer collT;
+    QuadTransformer quadT;
+    quadT.SetMaxFaceCount(maxFaceCount);
+    quadT.SetMaxQuadSize(maxQuadSize);
+    Timer timer;
+    timer.Start();
+    if (section == ModelEntry::PHYSIC)
+        collT.Transform(*root);
+    quadT.Transform(*root);
+    r.buildTime = timer.GetElapsedTime().AsInt();
+
+    SceneBounds bounds;
+    bounds.Build(*root);
+    r.nodes = bounds.Size();
+    r.geometryNodes = bounds.GetGeometryNodeCount();
+    r.faces = bounds.GetFaceCount();
+    r.memory = (unsigned long)r.faces * (sizeof(Face) + sizeof(FacePtr))
+        + r.nodes * sizeof(SceneNode);
+
+    // A circle around the middle of the scene, just above the ground
+    const float up[3] = { 0, 1, 0 };
+    unsigned long long candidates = 0;
+    timer.Reset();
+    timer.Start();
+    for (unsigned int i = 0; i < PATH_LENGTH; i++) {
+        float pos[3], dir[3];
+        bounds.Orbit((float)i / PATH_LENGTH, 20, pos, dir);
+        if (section == ModelEntry::PHYSIC) {
+            float min[3] = { pos[0] - 20, pos[1] - 20, pos[2] - 20 };
+            float max[3] = { pos[0] + 20, pos[1] + 20, pos[2] + 20 };
+            candidates += bounds.Query(min, max);
+        } else {
+            pos[1] += 20;
+            ViewFrustum f = ViewFrustum::Look(pos, dir, up, PI / 4,
+                                              4.0f / 3.0f, 20, 3000);
+            candidates += bounds.Cull(f);
+        }
+    }
+    r.queryTime = (float)timer.GetElapsedTime().AsInt() / PATH_LENGTH;
+    r.candidates = (float)candidates / PATH_LENGTH;
+
+    if (section == ModelEntry::PHYSIC) {
+        BSPTransformer bspT;
+        timer.Reset();
+        timer.Start();
+        bspT.Transform(*root);
+        r.buildTime += timer.GetElapsedTime().AsInt();
+    }
+
+    delete root;
+    return r;
+}
+
+const vector<QuadTuneResult>& QuadTuner::GetResults() const {
+    return results;
+}
+
+QuadTuneResult QuadTuner::GetBest() const {
+    if (results.empty())
+        throw Exception("No quad tree tuning results.");
+    float fewest = results[0].candidates;
+    for (unsigned int i = 1; i < results.size(); i++)
+        fewest = std::min(fewest, results[i].candidates);
+    unsigned int best = 0;
+    bool found = false;
+    for (unsigned int i = 0; i < results.size(); i++) {
+        if (results[i].candidates > fewest * 1.05f) continue;
+        if (!found || results[i].queryTime < results[best].queryTime)
+            best = i;
+        found = true;
+    }
+    return results[best];
+}
@@ -0,0 +1,74 @@
+// Parameter sweep of the quad tree settings.
+// -------------------------------------------------------------------
+// Copyright (C) 2007 OpenEngine.dk (See AUTHORS)
+//
+// This program is free software; It is covered by the GNU General
+// Public License version 2 or any later version.
+// See the GNU General Public License for more details (see LICENSE).
+//--------------------------------------------------------------------
+
+#ifndef _QUAD_TUNER_
+#define _QUAD_TUNER_
+
+#include "ModelLoader.h"
+
+#include <string>
+#include <vector>
+
+using std::string;
+using std::vector;
+
+/**
+ * Measurements of one quad tree configuration.
+ */
+struct QuadTuneResult {
+    unsigned int maxFaceCount;
+    unsigned int maxQuadSize;
+    unsigned int buildTime;       // usec, quad tree (and BSP) build
+    unsigned int nodes;
+    unsigned int geometryNodes;
+    unsigned int faces;
+    unsigned long memory;         // bytes, estimated
+    float queryTime;              // usec per query
+    float candidates;             // faces per query
+};
+
+/**
+ * Sweeps the QuadTransformer face count and quad size over the models
+ * of one manifest section.
+ *
+ * For every configuration the models are loaded from scratch and
+ * transformed, and the resulting tree is queried along a fixed path
+ * around the scene. The static section is queried with view frustums
+ * looking along the path, the physic section with a vehicle sized box
+ * moving along it. The best configuration is the one that leaves the
+ * fewest faces per query, with query time deciding between
+ * configurations within five percent of each other.
+ */
+class QuadTuner {
+private:
+    string manifest;
+    unsigned int threads;
+    vector<unsigned int> faceCounts;
+    vector<unsigned int> quadSizes;
+    vector<QuadTuneResult> results;
+
+    QuadTuneResult Measure(ModelEntry::Section section,
+                           unsigned int maxFaceCount,
+                           unsigned int maxQuadSize);
+
+public:
+    static const unsigned int PATH_LENGTH = 256;
+
+    QuadTuner(string manifest, unsigned int threads = 0);
+
+    void AddFaceCount(unsigned int count);
+    void AddQuadSize(unsigned int size);
+
+    void Run(ModelEntry::Section section);
+
+    const vector<QuadTuneResult>& GetResults() const;
+    QuadTuneResult GetBest() const;
+};
+
+#endif
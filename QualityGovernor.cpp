@@ -0,0 +1,89 @@
+#include "QualityGovernor.h"
+
+#include <Logging/Logger.h>
+
+namespace {
+// Settings of each quality level relative to the initial ones
+const float FAR_SCALE[QualityGovernor::LEVELS]     = { 1.0f, 0.8f, 0.6f, 0.4f };
+const float REFRESH_SCALE[QualityGovernor::LEVELS] = { 1.0f, 2.0f, 4.0f, 8.0f };
+const float LOD_SCALE[QualityGovernor::LEVELS]     = { 1.0f, 0.75f, 0.5f, 0.35f };
+
+// usec between adjustments
+const unsigned int ADJUST_INTERVAL = 500000;
+// Frame time relative to the target that lowers or raises the level
+const float LOWER = 1.1f;
+const float RAISE = 0.75f;
+}
+
+QualityGovernor::QualityGovernor(unsigned int targetFrameTime)
+    : target(targetFrameTime)
+    , average(targetFrameTime)
+    , level(0)
+    , changes(0)
+    , frustum(NULL)
+    , hud(NULL)
+    , lod(NULL)
+    , baseFar(0)
+    , baseRefresh(0)
+    , baseScale(1)
+{}
+
+void QualityGovernor::SetFrustum(Frustum* frustum) {
+    this->frustum = frustum;
+}
+
+void QualityGovernor::SetHUD(HUDPanel* hud) {
+    this->hud = hud;
+}
+
+void QualityGovernor::SetLOD(LODSelector* lod) {
+    this->lod = lod;
+}
+
+unsigned int QualityGovernor::GetLevel() const {
+    return level;
+}
+
+float QualityGovernor::GetAverageFrameTime() const {
+    return average;
+}
+
+void QualityGovernor::Apply() {
+    if (frustum != NULL) frustum->SetFar(baseFar * FAR_SCALE[level]);
+    if (hud != NULL)
+        hud->SetRefreshInterval((unsigned int)(baseRefresh * REFRESH_SCALE[level]));
+    if (lod != NULL) lod->SetDistanceScale(baseScale * LOD_SCALE[level]);
+}
+
+void QualityGovernor::Handle(InitializeEventArg arg) {
+    if (frustum != NULL) baseFar = frustum->GetFar();
+    if (hud != NULL) baseRefresh = hud->GetRefreshInterval();
+    if (lod != NULL) baseScale = lod->GetDistanceScale();
+    level = changes = 0;
+    average = target;
+    frameTimer.Start();
+    adjustTimer.Start();
+}
+
+void QualityGovernor::Handle(ProcessEventArg arg) {
+    unsigned int elapsed = frameTimer.GetElapsedTimeAndReset().AsInt();
+    average = average * 0.9f + elapsed * 0.1f;
+    if (adjustTimer.GetElapsedTime().AsInt() < ADJUST_INTERVAL) return;
+    adjustTimer.Reset();
+
+    unsigned int previous = level;
+    if (average > target * LOWER && level + 1 < LEVELS)
+        level++;
+    else if (average < target * RAISE && level > 0)
+        level--;
+    if (level == previous) return;
+    Apply();
+    changes++;
+    logger.info << "Quality level " << level << " at "
+                << average / 1000 << " ms per frame" << logger.end;
+}
+
+void QualityGovernor::Handle(DeinitializeEventArg arg) {
+    logger.info << "Quality governor: " << changes
+                << " level changes, ended at level " << level << logger.end;
+}
@@ -0,0 +1,73 @@
+// Frame time driven quality settings.
+// -------------------------------------------------------------------
+// Copyright (C) 2007 OpenEngine.dk (See AUTHORS)
+//
+// This program is free software; It is covered by the GNU General
+// Public License version 2 or any later version.
+// See the GNU General Public License for more details (see LICENSE).
+//--------------------------------------------------------------------
+
+#ifndef _QUALITY_GOVERNOR_
+#define _QUALITY_GOVERNOR_
+
+#include <Core/IModule.h>
+#include <Display/Frustum.h>
+#include <Utils/Timer.h>
+
+#include "HUDPanel.h"
+#include "LODSelector.h"
+
+using OpenEngine::Core::IModule;
+using OpenEngine::Core::InitializeEventArg;
+using OpenEngine::Core::ProcessEventArg;
+using OpenEngine::Core::DeinitializeEventArg;
+using OpenEngine::Display::Frustum;
+using OpenEngine::Utils::Timer;
+
+/**
+ * Lowers and restores the rendering quality to hold a target frame
+ * time.
+ *
+ * The frame time is averaged over the recent frames and compared to
+ * the target twice a second. Above the target the governor moves one
+ * quality level down: the far plane of the frustum comes closer, the
+ * HUD panel refreshes less often and the detail levels switch to the
+ * coarser geometry sooner. Well below the target it moves one level
+ * back up. The levels scale the settings the modules had when the
+ * engine was initialized, and any of the modules may be left out.
+ */
+class QualityGovernor : public IModule {
+private:
+    unsigned int target;          // usec
+    float average;                // usec
+    unsigned int level;
+    unsigned int changes;
+    Frustum* frustum;
+    HUDPanel* hud;
+    LODSelector* lod;
+    float baseFar;
+    unsigned int baseRefresh;
+    float baseScale;
+    Timer frameTimer;
+    Timer adjustTimer;
+
+    void Apply();
+
+public:
+    static const unsigned int LEVELS = 4;
+
+    QualityGovernor(unsigned int targetFrameTime);
+
+    void SetFrustum(Frustum* frustum);
+    void SetHUD(HUDPanel* hud);
+    void SetLOD(LODSelector* lod);
+
+    unsigned int GetLevel() const;
+    float GetAverageFrameTime() const;
+
+    void Handle(InitializeEventArg arg);
+    void Handle(ProcessEventArg arg);
+    void Handle(DeinitializeEventArg arg);
+};
+
+#endif
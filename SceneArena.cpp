@@ -0,0 +1,174 @@
+#include "SceneArena.h"
+#include "LockFree.h"
+
+#include <cstdlib>
+#include <new>
+
+#if __cplusplus >= 201103L
+#define ARENA_THROW
+#define ARENA_NOTHROW noexcept
+#else
+#define ARENA_THROW throw(std::bad_alloc)
+#define ARENA_NOTHROW throw()
+#endif
+
+#ifdef _MSC_VER
+#define ARENA_THREAD_LOCAL __declspec(thread)
+#else
+#define ARENA_THREAD_LOCAL __thread
+#endif
+
+namespace {
+
+// Plain statics, as operator new may run before any constructor
+const unsigned long ALIGNMENT = 16;
+
+volatile bool counting = false;
+volatile unsigned long allocations = 0;
+volatile unsigned long bytes = 0;
+volatile unsigned long frees = 0;
+
+// Only the thread that called Begin allocates from the arena, so the
+// offset and its counters are not shared. Frees come from any thread.
+char* base = NULL;
+unsigned long capacity = 0;
+unsigned long used = 0;
+ARENA_THREAD_LOCAL bool active = false;
+unsigned long arenaAllocations = 0;
+volatile unsigned long arenaFrees = 0;
+unsigned long overflows = 0;
+
+} // anonymous namespace
+
+void SceneArena::StartCounting() {
+    counting = true;
+    LOCKFREE_BARRIER();
+}
+
+void SceneArena::StopCounting() {
+    counting = false;
+    LOCKFREE_BARRIER();
+}
+
+SceneArena::Counters SceneArena::GetCounters() {
+    Counters c;
+    c.allocations = allocations;
+    c.bytes = bytes;
+    c.frees = frees;
+    return c;
+}
+
+// A new block is only reserved once the previous one is released
+bool SceneArena::Reserve(unsigned long size) {
+    if (base != NULL || size == 0) return false;
+    base = (char*)malloc(size);
+    if (base == NULL) return false;
+    capacity = size;
+    used = 0;
+    arenaAllocations = arenaFrees = overflows = 0;
+    return true;
+}
+
+void SceneArena::Begin() {
+    active = base != NULL;
+}
+
+void SceneArena::End() {
+    active = false;
+}
+
+void SceneArena::Release() {
+    active = false;
+    free(base);
+    base = NULL;
+    capacity = used = 0;
+}
+
+bool SceneArena::Contains(const void* p) {
+    return (const char*)p >= base && (const char*)p < base + capacity;
+}
+
+unsigned long SceneArena::GetCapacity() {
+    return capacity;
+}
+
+unsigned long SceneArena::GetUsed() {
+    return used;
+}
+
+unsigned long SceneArena::GetAllocationCount() {
+    return arenaAllocations;
+}
+
+unsigned long SceneArena::GetFreeCount() {
+    return arenaFrees;
+}
+
+unsigned long SceneArena::GetOverflowCount() {
+    return overflows;
+}
+
+void* SceneArena::Allocate(std::size_t size) {
+    if (counting) {
+        LOCKFREE_ADD(&allocations, 1);
+        LOCKFREE_ADD(&bytes, size);
+    }
+    if (active) {
+        unsigned long aligned = (size + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+        if (aligned == 0) aligned = ALIGNMENT;
+        if (used + aligned <= capacity) {
+            void* p = base + used;
+            used += aligned;
+            arenaAllocations++;
+            return p;
+        }
+        overflows++;
+    }
+    return malloc(size == 0 ? 1 : size);
+}
+
+void SceneArena::Free(void* p) {
+    if (p == NULL) return;
+    if (counting) LOCKFREE_ADD(&frees, 1);
+    if (Contains(p)) {
+        LOCKFREE_ADD(&arenaFrees, 1);
+        return;
+    }
+    free(p);
+}
+
+void* operator new(std::size_t size) ARENA_THROW {
+    void* p = SceneArena::Allocate(size);
+    if (p == NULL) throw std::bad_alloc();
+    return p;
+}
+
+void* operator new[](std::size_t size) ARENA_THROW {
+    void* p = SceneArena::Allocate(size);
+    if (p == NULL) throw std::bad_alloc();
+    return p;
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) ARENA_NOTHROW {
+    return SceneArena::Allocate(size);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) ARENA_NOTHROW {
+    return SceneArena::Allocate(size);
+}
+
+void operator delete(void* p) ARENA_NOTHROW {
+    SceneArena::Free(p);
+}
+
+void operator delete[](void* p) ARENA_NOTHROW {
+    SceneArena::Free(p);
+}
+
+void operator delete(void* p, const std::nothrow_t&) ARENA_NOTHROW {
+    SceneArena::Free(p);
+}
+
+void operator delete[](void* p, const std::nothrow_t&) ARENA_NOTHROW {
+    SceneArena::Free(p);
+}
@@ -0,0 +1,65 @@
+// Allocation counters and arena for the scene construction.
+// -------------------------------------------------------------------
+// Copyright (C) 2007 OpenEngine.dk (See AUTHORS)
+//
+// This program is free software; It is covered by the GNU General
+// Public License version 2 or any later version.
+// See the GNU General Public License for more details (see LICENSE).
+//--------------------------------------------------------------------
+
+#ifndef _SCENE_ARENA_
+#define _SCENE_ARENA_
+
+#include <cstddef>
+
+/**
+ * Counts the allocations of the process while the startup is
+ * profiled and optionally places the allocations of the setup thread
+ * in one contiguous arena while the scene is built.
+ *
+ * The global operator new and delete are replaced, since the scene
+ * nodes, faces and lights are allocated inside the engine loaders
+ * and transformers. The counters only run between StartCounting and
+ * StopCounting, which the startup profiler calls around its phases;
+ * outside of them an allocation costs a test of a flag.
+ *
+ * The arena is a single block reserved up front. Between Begin and
+ * End every allocation of the thread that called Begin is cut from
+ * the block by bumping its offset, so the nodes built in that time
+ * lie next to each other in memory. Other threads, such as the model
+ * loader workers, allocate from the heap as usual. Deleting memory
+ * in the arena does nothing; the space is only returned by Release,
+ * in one call, which must not happen while anything in the arena is
+ * still used. An allocation that does not fit any more is taken from
+ * the heap. Temporaries freed during the build stay in the arena, so
+ * its size should be chosen from the reported usage.
+ */
+class SceneArena {
+public:
+    struct Counters {
+        unsigned long allocations;
+        unsigned long bytes;
+        unsigned long frees;
+    };
+
+    static void StartCounting();
+    static void StopCounting();
+    static Counters GetCounters();
+
+    static bool Reserve(unsigned long capacity);
+    static void Begin();
+    static void End();
+    static void Release();
+
+    static bool Contains(const void* p);
+    static unsigned long GetCapacity();
+    static unsigned long GetUsed();
+    static unsigned long GetAllocationCount();
+    static unsigned long GetFreeCount();
+    static unsigned long GetOverflowCount();
+
+    static void* Allocate(std::size_t size);
+    static void Free(void* p);
+};
+
+#endif
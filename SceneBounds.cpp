@@ -0,0 +1,266 @@
+#include "SceneBounds.h"
+
+#include <Scene/GeometryNode.h>
+#include <Geometry/FaceSet.h>
+#include <Math/Math.h>
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define SCENE_BOUNDS_SSE
+#include <xmmintrin.h>
+#endif
+
+using OpenEngine::Scene::GeometryNode;
+using OpenEngine::Geometry::FaceSet;
+using OpenEngine::Geometry::FaceList;
+using OpenEngine::Math::PI;
+
+namespace {
+void Cross(const float a[3], const float b[3], float r[3]) {
+    r[0] = a[1]*b[2] - a[2]*b[1];
+    r[1] = a[2]*b[0] - a[0]*b[2];
+    r[2] = a[0]*b[1] - a[1]*b[0];
+}
+
+void Normalize(float v[3]) {
+    float l = sqrt(v[0]*v[0] + v[1]*v[1] + v[2]*v[2]);
+    if (l == 0) return;
+    v[0] /= l; v[1] /= l; v[2] /= l;
+}
+
+void SetPlane(ViewFrustum& f, int i, const float n[3], const float p[3]) {
+    f.a[i] = n[0]; f.b[i] = n[1]; f.c[i] = n[2];
+    f.d[i] = -(n[0]*p[0] + n[1]*p[1] + n[2]*p[2]);
+}
+}
+
+ViewFrustum ViewFrustum::Look(const float position[3],
+                              const float direction[3],
+                              const float up[3],
+                              float fovy, float aspect,
+                              float zNear, float zFar) {
+    float dir[3] = { direction[0], direction[1], direction[2] };
+    Normalize(dir);
+    float right[3], top[3];
+    Cross(dir, up, right);
+    Normalize(right);
+    Cross(right, dir, top);
+
+    float tanV = tan(fovy * 0.5f);
+    float tanH = tanV * aspect;
+    ViewFrustum f;
+    float n[3], p[3];
+
+    // near and far
+    for (int k = 0; k < 3; k++) p[k] = position[k] + dir[k] * zNear;
+    SetPlane(f, 0, dir, p);
+    for (int k = 0; k < 3; k++) {
+        p[k] = position[k] + dir[k] * zFar;
+        n[k] = -dir[k];
+    }
+    SetPlane(f, 1, n, p);
+
+    // left, right, bottom, top through the eye
+    for (int k = 0; k < 3; k++) n[k] = dir[k] * tanH + right[k];
+    Normalize(n); SetPlane(f, 2, n, position);
+    for (int k = 0; k < 3; k++) n[k] = dir[k] * tanH - right[k];
+    Normalize(n); SetPlane(f, 3, n, position);
+    for (int k = 0; k < 3; k++) n[k] = dir[k] * tanV + top[k];
+    Normalize(n); SetPlane(f, 4, n, position);
+    for (int k = 0; k < 3; k++) n[k] = dir[k] * tanV - top[k];
+    Normalize(n); SetPlane(f, 5, n, position);
+    return f;
+}
+
+SceneBounds::SceneBounds()
+    : geometryNodes(0)
+    , faceCount(0)
+{}
+
+void SceneBounds::Clear() {
+    minX.clear(); minY.clear(); minZ.clear();
+    maxX.clear(); maxY.clear(); maxZ.clear();
+    skip.clear(); faces.clear(); nodes.clear();
+    geometryNodes = faceCount = 0;
+}
+
+void SceneBounds::Build(ISceneNode& root) {
+    Clear();
+    Add(&root);
+}
+
+// Adds the node and its subtree, returns the node index. Nodes
+// without any faces below them get inverted (empty) bounds.
+unsigned int SceneBounds::Add(ISceneNode* node) {
+    unsigned int i = minX.size();
+    minX.push_back(FLT_MAX);  minY.push_back(FLT_MAX);  minZ.push_back(FLT_MAX);
+    maxX.push_back(-FLT_MAX); maxY.push_back(-FLT_MAX); maxZ.push_back(-FLT_MAX);
+    skip.push_back(0);
+    faces.push_back(0);
+    nodes.push_back(node);
+
+    GeometryNode* geom = dynamic_cast<GeometryNode*>(node);
+    if (geom != NULL && geom->GetFaceSet() != NULL) {
+        geometryNodes++;
+        FaceSet* fs = geom->GetFaceSet();
+        for (FaceList::iterator itr = fs->begin(); itr != fs->end(); itr++) {
+            for (int v = 0; v < 3; v++) {
+                const Vector<3,float>& p = (*itr)->vert[v];
+                minX[i] = std::min(minX[i], p[0]); maxX[i] = std::max(maxX[i], p[0]);
+                minY[i] = std::min(minY[i], p[1]); maxY[i] = std::max(maxY[i], p[1]);
+                minZ[i] = std::min(minZ[i], p[2]); maxZ[i] = std::max(maxZ[i], p[2]);
+            }
+            faces[i]++;
+        }
+        faceCount += faces[i];
+    }
+
+    for (unsigned int n = 0; n < node->GetNumberOfNodes(); n++) {
+        unsigned int c = Add(node->GetNode(n));
+        minX[i] = std::min(minX[i], minX[c]); maxX[i] = std::max(maxX[i], maxX[c]);
+        minY[i] = std::min(minY[i], minY[c]); maxY[i] = std::max(maxY[i], maxY[c]);
+        minZ[i] = std::min(minZ[i], minZ[c]); maxZ[i] = std::max(maxZ[i], maxZ[c]);
+    }
+    skip[i] = minX.size();
+    return i;
+}
+
+unsigned int SceneBounds::Size() const {
+    return minX.size();
+}
+
+unsigned int SceneBounds::GetGeometryNodeCount() const {
+    return geometryNodes;
+}
+
+unsigned int SceneBounds::GetFaceCount() const {
+    return faceCount;
+}
+
+// Point and tangent at t (0 to 1) on a circle around the middle of
+// the scene, height above its bottom. Used as a fixed camera path.
+void SceneBounds::Orbit(float t, float height,
+                        float position[3], float direction[3]) const {
+    float radius = std::max(maxX[0] - minX[0], maxZ[0] - minZ[0]) * 0.35f;
+    float angle = 2 * PI * t;
+    float c = cos(angle), s = sin(angle);
+    position[0] = (minX[0] + maxX[0]) * 0.5f + c * radius;
+    position[1] = minY[0] + height;
+    position[2] = (minZ[0] + maxZ[0]) * 0.5f + s * radius;
+    direction[0] = -s;
+    direction[1] = 0;
+    direction[2] = c;
+}
+
+// Hierarchical culling, one node at a time. A box is outside when its
+// corner furthest along a plane normal is behind the plane. Returns
+// the number of faces in visible nodes.
+unsigned int SceneBounds::Cull(const ViewFrustum& f) const {
+    unsigned int visible = 0;
+    const unsigned int n = minX.size();
+    unsigned int i = 0;
+    while (i < n) {
+        bool outside = minX[i] > maxX[i];
+        for (int p = 0; p < 6 && !outside; p++) {
+            float x = f.a[p] > 0 ? maxX[i] : minX[i];
+            float y = f.b[p] > 0 ? maxY[i] : minY[i];
+            float z = f.c[p] > 0 ? maxZ[i] : minZ[i];
+            outside = f.a[p]*x + f.b[p]*y + f.c[p]*z + f.d[p] < 0;
+        }
+        if (outside) {
+            i = skip[i];
+            continue;
+        }
+        visible += faces[i];
+        i++;
+    }
+    return visible;
+}
+
+// Number of faces in the nodes overlapping the box, that is the faces
+// a collision query with the box would have to test.
+unsigned int SceneBounds::Query(const float min[3], const float max[3]) const {
+    unsigned int candidates = 0;
+    const unsigned int n = minX.size();
+    unsigned int i = 0;
+    while (i < n) {
+        if (minX[i] > max[0] || maxX[i] < min[0] ||
+            minY[i] > max[1] || maxY[i] < min[1] ||
+            minZ[i] > max[2] || maxZ[i] < min[2]) {
+            i = skip[i];
+            continue;
+        }
+        candidates += faces[i];
+        i++;
+    }
+    return candidates;
+}
+
+// Flat pass over all boxes followed by the hierarchical walk. Each
+// plane has a fixed sign pattern, so the corner furthest along its
+// normal comes from the same arrays for every box and the test is a
+// straight line of multiply-adds over the arrays. Empty boxes fail
+// the plane test on their own as their min exceeds their max.
+unsigned int SceneBounds::CullBatch(const ViewFrustum& f,
+                                    vector<unsigned char>& inside) const {
+    const unsigned int n = minX.size();
+    inside.resize(n);
+    if (n == 0) return 0;
+    unsigned char* in = &inside[0];
+
+    const float* x[6]; const float* y[6]; const float* z[6];
+    for (int p = 0; p < 6; p++) {
+        x[p] = f.a[p] > 0 ? &maxX[0] : &minX[0];
+        y[p] = f.b[p] > 0 ? &maxY[0] : &minY[0];
+        z[p] = f.c[p] > 0 ? &maxZ[0] : &minZ[0];
+    }
+
+    unsigned int i = 0;
+#ifdef SCENE_BOUNDS_SSE
+    __m128 a[6], b[6], c[6], d[6];
+    for (int p = 0; p < 6; p++) {
+        a[p] = _mm_set1_ps(f.a[p]); b[p] = _mm_set1_ps(f.b[p]);
+        c[p] = _mm_set1_ps(f.c[p]); d[p] = _mm_set1_ps(f.d[p]);
+    }
+    const __m128 zero = _mm_setzero_ps();
+    for (; i + 4 <= n; i += 4) {
+        __m128 outside = _mm_cmpgt_ps(_mm_loadu_ps(&minX[i]), _mm_loadu_ps(&maxX[i]));
+        for (int p = 0; p < 6; p++) {
+            // ((a*x + b*y) + c*z) + d, the order of the scalar test
+            __m128 dist = _mm_add_ps(
+                _mm_add_ps(
+                    _mm_add_ps(_mm_mul_ps(a[p], _mm_loadu_ps(x[p] + i)),
+                               _mm_mul_ps(b[p], _mm_loadu_ps(y[p] + i))),
+                    _mm_mul_ps(c[p], _mm_loadu_ps(z[p] + i))),
+                d[p]);
+            outside = _mm_or_ps(outside, _mm_cmplt_ps(dist, zero));
+        }
+        int mask = _mm_movemask_ps(outside);
+        in[i]     = !(mask & 1);
+        in[i + 1] = !(mask & 2);
+        in[i + 2] = !(mask & 4);
+        in[i + 3] = !(mask & 8);
+    }
+#endif
+    for (; i < n; i++) {
+        bool outside = minX[i] > maxX[i];
+        for (int p = 0; p < 6; p++)
+            outside |= f.a[p]*x[p][i] + f.b[p]*y[p][i] + f.c[p]*z[p][i] + f.d[p] < 0;
+        in[i] = !outside;
+    }
+
+    unsigned int visible = 0;
+    i = 0;
+    while (i < n) {
+        if (!in[i]) {
+            i = skip[i];
+            continue;
+        }
+        visible += faces[i];
+        i++;
+    }
+    return visible;
+}
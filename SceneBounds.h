@@ -0,0 +1,79 @@
+// Flattened bounding volume hierarchy of a scene graph.
+// -------------------------------------------------------------------
+// Copyright (C) 2007 OpenEngine.dk (See AUTHORS)
+//
+// This program is free software; It is covered by the GNU General
+// Public License version 2 or any later version.
+// See the GNU General Public License for more details (see LICENSE).
+//--------------------------------------------------------------------
+
+#ifndef _SCENE_BOUNDS_
+#define _SCENE_BOUNDS_
+
+#include <Scene/ISceneNode.h>
+
+#include <vector>
+
+using OpenEngine::Scene::ISceneNode;
+using std::vector;
+
+/**
+ * The six planes of a viewing frustum, normals pointing inwards.
+ * Plane i is a[i]*x + b[i]*y + c[i]*z + d[i] = 0.
+ */
+struct ViewFrustum {
+    float a[6], b[6], c[6], d[6];
+
+    static ViewFrustum Look(const float position[3],
+                            const float direction[3],
+                            const float up[3],
+                            float fovy, float aspect,
+                            float zNear, float zFar);
+};
+
+/**
+ * Axis aligned bounds of every node of a scene graph, stored in
+ * depth first order in contiguous arrays.
+ *
+ * Each node records the index following its subtree, so a culling
+ * pass is a single loop over the arrays that jumps past rejected
+ * subtrees instead of walking the pointer based scene graph. Node
+ * transformations are ignored, which holds for the static scene.
+ *
+ * CullBatch first tests every box against the frustum, four boxes
+ * at a time with SSE where available, and then walks the hierarchy
+ * over the results. It gives the same answer as Cull.
+ */
+class SceneBounds {
+public:
+    vector<float> minX, minY, minZ;
+    vector<float> maxX, maxY, maxZ;
+    vector<unsigned int> skip;    // first index after the subtree
+    vector<unsigned int> faces;   // faces stored in the node itself
+    vector<ISceneNode*> nodes;
+
+private:
+    unsigned int geometryNodes;
+    unsigned int faceCount;
+
+    unsigned int Add(ISceneNode* node);
+
+public:
+    SceneBounds();
+
+    void Build(ISceneNode& root);
+    void Clear();
+
+    unsigned int Size() const;
+    unsigned int GetGeometryNodeCount() const;
+    unsigned int GetFaceCount() const;
+
+    void Orbit(float t, float height, float position[3], float direction[3]) const;
+
+    unsigned int Cull(const ViewFrustum& frustum) const;
+    unsigned int CullBatch(const ViewFrustum& frustum,
+                           vector<unsigned char>& inside) const;
+    unsigned int Query(const float min[3], const float max[3]) const;
+};
+
+#endif
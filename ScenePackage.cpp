@@ -0,0 +1,472 @@
+// Serialization (must be first)
+#include <fstream>
+#include <Utils/Serialization.h>
+
+#include "ScenePackage.h"
+
+#include <Geometry/Face.h>
+#include <Geometry/FaceSet.h>
+#include <Geometry/Material.h>
+#include <Logging/Logger.h>
+#include <Resources/ITextureResource.h>
+#include <Scene/GeometryNode.h>
+#include <Scene/SceneNode.h>
+
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <sstream>
+#include <vector>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using OpenEngine::Geometry::Face;
+using OpenEngine::Geometry::FaceList;
+using OpenEngine::Geometry::FacePtr;
+using OpenEngine::Geometry::FaceSet;
+using OpenEngine::Geometry::Material;
+using OpenEngine::Geometry::MaterialPtr;
+using OpenEngine::Resources::ITextureResource;
+using OpenEngine::Resources::ITextureResourcePtr;
+using OpenEngine::Scene::GeometryNode;
+using OpenEngine::Scene::SceneNode;
+using OpenEngine::Utils::Serialization;
+using std::map;
+using std::vector;
+
+namespace {
+const char MAGIC[4] = { 'O', 'E', 'S', 'P' };
+
+struct Header {
+    char magic[4];
+    unsigned int version;
+    boost::uint64_t key;
+    unsigned int structureSize;
+    unsigned int textureCount;
+    unsigned int materialCount;
+    unsigned int nodeCount;
+    unsigned int vertexCount;
+    unsigned int indexCount;
+};
+
+struct TextureRecord {
+    unsigned int width, height, depth;
+    unsigned int offset;                // pixels, from the file start
+};
+
+struct MaterialRecord {
+    float diffuse[4], ambient[4], specular[4], emission[4];
+    float shininess;
+    int texture;                        // -1 for none
+};
+
+struct NodeRecord {
+    unsigned int firstVertex;
+    unsigned int firstIndex, indexCount;
+};
+
+struct Vertex {
+    float data[12];                     // position, normal, uv, color
+    bool operator<(const Vertex& other) const {
+        return memcmp(data, other.data, sizeof(data)) < 0;
+    }
+};
+
+boost::uint64_t Pad(boost::uint64_t size) {
+    return (size + 3) & ~(boost::uint64_t)3;
+}
+
+void CollectGeometry(ISceneNode* node, vector<GeometryNode*>& nodes) {
+    GeometryNode* geom = dynamic_cast<GeometryNode*>(node);
+    if (geom != NULL) nodes.push_back(geom);
+    for (unsigned int i = 0; i < node->GetNumberOfNodes(); i++)
+        CollectGeometry(node->GetNode(i), nodes);
+}
+
+/**
+ * Texture whose pixels live in a mapped package. The pixels are
+ * owned by the package, Load and Unload do nothing.
+ */
+class PackageTexture : public ITextureResource {
+private:
+    int id;
+    unsigned int width, height, depth;
+    unsigned char* pixels;
+public:
+    PackageTexture(const TextureRecord& record, char* file)
+        : id(0)
+        , width(record.width)
+        , height(record.height)
+        , depth(record.depth)
+        , pixels((unsigned char*)file + record.offset) {}
+    int GetID() { return id; }
+    void SetID(int id) { this->id = id; }
+    void Load() {}
+    void Unload() {}
+    unsigned int GetWidth() { return width; }
+    unsigned int GetHeight() { return height; }
+    unsigned int GetDepth() { return depth; }
+    unsigned char* GetData() { return pixels; }
+};
+}
+
+ScenePackage::ScenePackage(string file)
+    : file(file)
+    , data(NULL)
+    , size(0)
+{
+    key.AddParameter("version", VERSION);
+}
+
+ScenePackage::~ScenePackage() {
+    Unmap();
+}
+
+void ScenePackage::AddSource(string file) {
+    key.AddSource(file);
+}
+
+void ScenePackage::AddParameter(string name, unsigned int value) {
+    key.AddParameter(name, value);
+}
+
+string ScenePackage::GetFileName() const {
+    return file;
+}
+
+void ScenePackage::Unmap() {
+    if (data == NULL) return;
+#ifdef _WIN32
+    delete[] data;
+#else
+    munmap(data, size);
+#endif
+    data = NULL;
+    size = 0;
+}
+
+bool ScenePackage::Load(ISceneNode& root) {
+    Unmap();
+#ifdef _WIN32
+    std::ifstream in(file.c_str(), std::ios::binary);
+    if (!in.is_open()) return false;
+    in.seekg(0, std::ios::end);
+    size = in.tellg();
+    in.seekg(0, std::ios::beg);
+    data = new char[size];
+    in.read(data, size);
+    if (!in) {
+        Unmap();
+        return false;
+    }
+#else
+    int fd = open(file.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < (off_t)sizeof(Header)) {
+        close(fd);
+        return false;
+    }
+    size = st.st_size;
+    void* mapped = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapped == MAP_FAILED) {
+        size = 0;
+        return false;
+    }
+    data = (char*)mapped;
+#endif
+
+    const Header* header = (const Header*)data;
+    if (size < sizeof(Header) ||
+        memcmp(header->magic, MAGIC, sizeof(MAGIC)) != 0 ||
+        header->version != VERSION ||
+        header->key != key.Get()) {
+        logger.info << "Scene package " << file << " is stale" << logger.end;
+        Unmap();
+        return false;
+    }
+
+    // The tables follow the header in file order
+    boost::uint64_t offset = sizeof(Header);
+    const char* structureData = data + offset;
+    offset += Pad(header->structureSize);
+    const TextureRecord* textures = (const TextureRecord*)(data + offset);
+    offset += header->textureCount * sizeof(TextureRecord);
+    const MaterialRecord* materials = (const MaterialRecord*)(data + offset);
+    offset += header->materialCount * sizeof(MaterialRecord);
+    const NodeRecord* nodes = (const NodeRecord*)(data + offset);
+    offset += header->nodeCount * sizeof(NodeRecord);
+    const Vertex* vertices = (const Vertex*)(data + offset);
+    offset += header->vertexCount * sizeof(Vertex);
+    const unsigned int* indices = (const unsigned int*)(data + offset);
+    offset += header->indexCount * sizeof(unsigned int);
+    const unsigned int* faceMaterials = (const unsigned int*)(data + offset);
+    offset += header->indexCount / 3 * sizeof(unsigned int);
+    if (offset > size) {
+        logger.warning << "Scene package " << file << " is truncated" << logger.end;
+        Unmap();
+        return false;
+    }
+
+    // Everything the tables refer to must lie within the package, as
+    // the faces and textures are read from it without further checks
+    bool valid = header->indexCount % 3 == 0;
+    for (unsigned int i = 0; valid && i < header->textureCount; i++) {
+        const TextureRecord& t = textures[i];
+        valid = t.depth != 0 && t.depth <= 32 && t.depth % 8 == 0 &&
+            (boost::uint64_t)t.width * t.height <= size &&
+            t.offset + Pad((boost::uint64_t)t.width * t.height * (t.depth / 8))
+                <= size;
+    }
+    for (unsigned int i = 0; valid && i < header->materialCount; i++)
+        valid = materials[i].texture < 0 ||
+            (unsigned int)materials[i].texture < header->textureCount;
+    for (unsigned int n = 0; valid && n < header->nodeCount; n++) {
+        const NodeRecord& node = nodes[n];
+        valid = node.firstIndex % 3 == 0 && node.indexCount % 3 == 0 &&
+            (boost::uint64_t)node.firstIndex + node.indexCount <= header->indexCount;
+        for (unsigned int i = node.firstIndex;
+             valid && i < node.firstIndex + node.indexCount; i++)
+            valid = (boost::uint64_t)node.firstVertex + indices[i]
+                < header->vertexCount;
+    }
+    for (unsigned int i = 0; valid && i < header->indexCount / 3; i++)
+        valid = faceMaterials[i] < header->materialCount;
+    if (!valid) {
+        logger.warning << "Scene package " << file << " is damaged" << logger.end;
+        Unmap();
+        return false;
+    }
+    std::istringstream structure(string(structureData, header->structureSize));
+
+    // The structure is read into a node of its own and only moved to
+    // the root once it is known to match, so a failed load leaves the
+    // root as it was
+    SceneNode* loaded = new SceneNode();
+    vector<GeometryNode*> geoms;
+    bool parsed = true;
+    try {
+        Serialization::Deserialize(*loaded, &structure);
+        CollectGeometry(loaded, geoms);
+    } catch (...) {
+        parsed = false;
+    }
+    if (!parsed || geoms.size() != header->nodeCount) {
+        logger.warning << "Scene package " << file
+                       << " does not match its structure" << logger.end;
+        delete loaded;
+        Unmap();
+        return false;
+    }
+
+    vector<ITextureResourcePtr> texrs;
+    for (unsigned int i = 0; i < header->textureCount; i++)
+        texrs.push_back(ITextureResourcePtr(new PackageTexture(textures[i], data)));
+    vector<MaterialPtr> mats;
+    for (unsigned int i = 0; i < header->materialCount; i++) {
+        const MaterialRecord& r = materials[i];
+        MaterialPtr mat(new Material());
+        mat->diffuse  = Vector<4,float>(r.diffuse[0],  r.diffuse[1],  r.diffuse[2],  r.diffuse[3]);
+        mat->ambient  = Vector<4,float>(r.ambient[0],  r.ambient[1],  r.ambient[2],  r.ambient[3]);
+        mat->specular = Vector<4,float>(r.specular[0], r.specular[1], r.specular[2], r.specular[3]);
+        mat->emission = Vector<4,float>(r.emission[0], r.emission[1], r.emission[2], r.emission[3]);
+        mat->shininess = r.shininess;
+        if (r.texture >= 0) mat->texr = texrs[r.texture];
+        mats.push_back(mat);
+    }
+
+    for (unsigned int n = 0; n < header->nodeCount; n++) {
+        const NodeRecord& node = nodes[n];
+        FaceSet* fs = new FaceSet();
+        for (unsigned int i = node.firstIndex;
+             i < node.firstIndex + node.indexCount; i += 3) {
+            const float* v[3];
+            for (int k = 0; k < 3; k++)
+                v[k] = vertices[node.firstVertex + indices[i + k]].data;
+            FacePtr face(new Face(Vector<3,float>(v[0][0], v[0][1], v[0][2]),
+                                  Vector<3,float>(v[1][0], v[1][1], v[1][2]),
+                                  Vector<3,float>(v[2][0], v[2][1], v[2][2])));
+            for (int k = 0; k < 3; k++) {
+                face->norm[k] = Vector<3,float>(v[k][3], v[k][4], v[k][5]);
+                face->texc[k] = Vector<2,float>(v[k][6], v[k][7]);
+                face->colr[k] = Vector<4,float>(v[k][8], v[k][9], v[k][10], v[k][11]);
+            }
+            face->mat = mats[faceMaterials[i / 3]];
+            fs->Add(face);
+        }
+        geoms[n]->SetFaceSet(fs);
+    }
+
+    while (loaded->GetNumberOfNodes() != 0) {
+        ISceneNode* child = loaded->GetNode(0);
+        loaded->RemoveNode(child);
+        root.AddNode(child);
+    }
+    delete loaded;
+    return true;
+}
+
+// Moves the faces of the scene into the package. The scene is left
+// with empty geometry nodes.
+bool ScenePackage::Bake(ISceneNode& root) {
+    vector<GeometryNode*> geoms;
+    CollectGeometry(&root, geoms);
+
+    map<ITextureResource*, int> textureIndex;
+    vector<ITextureResourcePtr> texrs;
+    map<Material*, unsigned int> materialIndex;
+    vector<MaterialRecord> materials;
+    vector<NodeRecord> nodes;
+    vector<Vertex> vertices;
+    vector<unsigned int> indices;
+    vector<unsigned int> faceMaterials;
+
+    for (unsigned int n = 0; n < geoms.size(); n++) {
+        NodeRecord node;
+        node.firstVertex = vertices.size();
+        node.firstIndex = indices.size();
+        map<Vertex, unsigned int> unique;
+        FaceSet* fs = geoms[n]->GetFaceSet();
+        if (fs != NULL) {
+            for (FaceList::iterator itr = fs->begin(); itr != fs->end(); itr++) {
+                FacePtr face = *itr;
+                for (int k = 0; k < 3; k++) {
+                    Vertex v;
+                    for (int c = 0; c < 3; c++) v.data[c]     = face->vert[k][c];
+                    for (int c = 0; c < 3; c++) v.data[3 + c] = face->norm[k][c];
+                    for (int c = 0; c < 2; c++) v.data[6 + c] = face->texc[k][c];
+                    for (int c = 0; c < 4; c++) v.data[8 + c] = face->colr[k][c];
+                    map<Vertex, unsigned int>::iterator u = unique.find(v);
+                    if (u == unique.end()) {
+                        u = unique.insert(std::make_pair(v, (unsigned int)
+                                          (vertices.size() - node.firstVertex))).first;
+                        vertices.push_back(v);
+                    }
+                    indices.push_back(u->second);
+                }
+
+                Material* mat = face->mat.get();
+                map<Material*, unsigned int>::iterator m = materialIndex.find(mat);
+                if (m == materialIndex.end()) {
+                    MaterialRecord r;
+                    memset(&r, 0, sizeof(r));
+                    r.texture = -1;
+                    if (mat != NULL) {
+                        for (int c = 0; c < 4; c++) {
+                            r.diffuse[c]  = mat->diffuse[c];
+                            r.ambient[c]  = mat->ambient[c];
+                            r.specular[c] = mat->specular[c];
+                            r.emission[c] = mat->emission[c];
+                        }
+                        r.shininess = mat->shininess;
+                        ITextureResource* texr = mat->texr.get();
+                        if (texr != NULL) {
+                            if (textureIndex.find(texr) == textureIndex.end()) {
+                                textureIndex[texr] = texrs.size();
+                                texrs.push_back(mat->texr);
+                            }
+                            r.texture = textureIndex[texr];
+                        }
+                    }
+                    m = materialIndex.insert(std::make_pair(mat, (unsigned int)
+                                             materials.size())).first;
+                    materials.push_back(r);
+                }
+                faceMaterials.push_back(m->second);
+            }
+        }
+        node.indexCount = indices.size() - node.firstIndex;
+        nodes.push_back(node);
+        geoms[n]->SetFaceSet(new FaceSet());
+    }
+
+    std::ostringstream structure;
+    Serialization::Serialize(root, &structure);
+    string tree = structure.str();
+
+    // Decode the textures and lay out their pixels after the tables
+    Header header;
+    memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = VERSION;
+    header.key = key.Get();
+    header.structureSize = tree.size();
+    header.textureCount = texrs.size();
+    header.materialCount = materials.size();
+    header.nodeCount = nodes.size();
+    header.vertexCount = vertices.size();
+    header.indexCount = indices.size();
+
+    unsigned int offset = sizeof(Header) + Pad(tree.size())
+        + texrs.size() * sizeof(TextureRecord)
+        + materials.size() * sizeof(MaterialRecord)
+        + nodes.size() * sizeof(NodeRecord)
+        + vertices.size() * sizeof(Vertex)
+        + indices.size() * sizeof(unsigned int)
+        + faceMaterials.size() * sizeof(unsigned int);
+    vector<TextureRecord> textures;
+    for (unsigned int i = 0; i < texrs.size(); i++) {
+        texrs[i]->Load();
+        TextureRecord r;
+        r.width = texrs[i]->GetWidth();
+        r.height = texrs[i]->GetHeight();
+        r.depth = texrs[i]->GetDepth();
+        r.offset = offset;
+        offset += Pad(r.width * r.height * r.depth / 8);
+        textures.push_back(r);
+    }
+
+    // Written next to the package and moved over it once complete, so
+    // an interrupted bake never leaves a package that looks current
+    string temp = file + ".tmp";
+    std::ofstream out(temp.c_str(), std::ios::binary);
+    if (!out.is_open()) {
+        logger.warning << "Can not write scene package " << file << logger.end;
+        return false;
+    }
+    const char zeros[4] = { 0, 0, 0, 0 };
+    out.write((const char*)&header, sizeof(header));
+    out.write(tree.data(), tree.size());
+    out.write(zeros, Pad(tree.size()) - tree.size());
+    if (!textures.empty())
+        out.write((const char*)&textures[0], textures.size() * sizeof(TextureRecord));
+    if (!materials.empty())
+        out.write((const char*)&materials[0], materials.size() * sizeof(MaterialRecord));
+    if (!nodes.empty())
+        out.write((const char*)&nodes[0], nodes.size() * sizeof(NodeRecord));
+    if (!vertices.empty())
+        out.write((const char*)&vertices[0], vertices.size() * sizeof(Vertex));
+    if (!indices.empty()) {
+        out.write((const char*)&indices[0], indices.size() * sizeof(unsigned int));
+        out.write((const char*)&faceMaterials[0], faceMaterials.size() * sizeof(unsigned int));
+    }
+    for (unsigned int i = 0; i < texrs.size(); i++) {
+        unsigned int bytes = textures[i].width * textures[i].height * textures[i].depth / 8;
+        out.write((const char*)texrs[i]->GetData(), bytes);
+        out.write(zeros, Pad(bytes) - bytes);
+        texrs[i]->Unload();
+    }
+    out.close();
+    if (!out.good()) {
+        logger.warning << "Can not write scene package " << file << logger.end;
+        remove(temp.c_str());
+        return false;
+    }
+    // rename does not replace an existing file everywhere
+    remove(file.c_str());
+    if (rename(temp.c_str(), file.c_str()) != 0) {
+        logger.warning << "Can not write scene package " << file << logger.end;
+        remove(temp.c_str());
+        return false;
+    }
+    logger.info << "Baked " << nodes.size() << " geometry nodes, "
+                << vertices.size() << " vertices, " << indices.size() / 3
+                << " faces and " << texrs.size() << " textures into "
+                << file << logger.end;
+    return true;
+}
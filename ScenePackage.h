@@ -0,0 +1,62 @@
+// Baked binary package of the static scene.
+// -------------------------------------------------------------------
+// Copyright (C) 2007 OpenEngine.dk (See AUTHORS)
+//
+// This program is free software; It is covered by the GNU General
+// Public License version 2 or any later version.
+// See the GNU General Public License for more details (see LICENSE).
+//--------------------------------------------------------------------
+
+#ifndef _SCENE_PACKAGE_
+#define _SCENE_PACKAGE_
+
+#include "ContentKey.h"
+
+#include <Scene/ISceneNode.h>
+
+#include <string>
+
+using OpenEngine::Scene::ISceneNode;
+using std::string;
+
+/**
+ * Single file package of the transformed static scene.
+ *
+ * Bake writes the scene after the QuadTransformer pass: the tree
+ * structure with empty geometry nodes, stored with the engine
+ * serialization, followed by flat tables of materials, indexed
+ * vertices per geometry node and decoded texture pixels. Load maps
+ * the file into memory, restores the tree and refills its geometry
+ * nodes from the tables, so neither the OBJ and TGA files nor the
+ * quad tree transformation are touched at startup. The textures
+ * point straight into the mapped file, so the package must outlive
+ * the scene it loaded.
+ *
+ * The header carries a format version and a ContentKey of the
+ * sources, and a package that does not match is not loaded.
+ */
+class ScenePackage {
+private:
+    static const unsigned int VERSION = 1;
+
+    string file;
+    ContentKey key;
+    char* data;
+    unsigned int size;
+
+    void Unmap();
+
+public:
+    ScenePackage(string file);
+    ~ScenePackage();
+
+    void AddSource(string file);
+    void AddParameter(string name, unsigned int value);
+
+    string GetFileName() const;
+
+    bool Load(ISceneNode& root);
+    bool Bake(ISceneNode& root);
+};
+
+#endif
@@ -0,0 +1,155 @@
+#include "StartupProfiler.h"
+
+#include <Logging/Logger.h>
+
+#include <fstream>
+
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
+
+using std::ofstream;
+
+namespace {
+// A string as a JSON string literal
+string Quote(const string& s) {
+    string quoted = "\"";
+    for (unsigned int i = 0; i < s.size(); i++) {
+        if (s[i] == '"' || s[i] == '\\') quoted += '\\';
+        quoted += s[i];
+    }
+    return quoted + "\"";
+}
+}
+
+StartupProfiler::StartupProfiler() {
+    timer.Start();
+}
+
+StartupProfiler::~StartupProfiler() {
+    for (unsigned int i = 0; i < proxies.size(); i++)
+        delete proxies[i];
+}
+
+void StartupProfiler::Begin(string name, string category) {
+    Record r;
+    r.name = name;
+    r.category = category;
+    r.depth = open.size();
+    r.start = timer.GetElapsedTime().AsInt();
+    r.duration = 0;
+    r.peakMemory = 0;
+    r.allocations = 0;
+    r.allocatedBytes = 0;
+    if (open.empty()) SceneArena::StartCounting();
+    open.push_back(records.size());
+    openCounters.push_back(SceneArena::GetCounters());
+    records.push_back(r);
+}
+
+void StartupProfiler::End() {
+    if (open.empty()) return;
+    SceneArena::Counters now = SceneArena::GetCounters();
+    Record& r = records[open.back()];
+    open.pop_back();
+    r.duration = timer.GetElapsedTime().AsInt() - r.start;
+    r.peakMemory = GetPeakMemory();
+    r.allocations = now.allocations - openCounters.back().allocations;
+    r.allocatedBytes = now.bytes - openCounters.back().bytes;
+    openCounters.pop_back();
+    if (open.empty()) SceneArena::StopCounting();
+}
+
+void StartupProfiler::Add(string name, string category, unsigned int duration) {
+    Add(name, category, duration, timer.GetElapsedTime().AsInt());
+}
+
+// Work timed elsewhere that started at the given profiler time, nested
+// in the open phases
+void StartupProfiler::Add(string name, string category, unsigned int duration,
+                          unsigned int start) {
+    Record r;
+    r.name = name;
+    r.category = category;
+    r.depth = open.size();
+    r.start = start;
+    r.duration = duration;
+    r.peakMemory = GetPeakMemory();
+    r.allocations = 0;
+    r.allocatedBytes = 0;
+    records.push_back(r);
+}
+
+// Usec since the profiler was created
+unsigned int StartupProfiler::GetTime() {
+    return timer.GetElapsedTime().AsInt();
+}
+
+void StartupProfiler::SetReportFile(string file) {
+    reportFile = file;
+}
+
+void StartupProfiler::Handle(InitializeEventArg arg) {
+    while (!open.empty()) End();
+
+    logger.info << "Startup times in ms (peak memory in kb, allocations, "
+                << "allocated kb):" << logger.end;
+    for (unsigned int i = 0; i < records.size(); i++) {
+        const Record& r = records[i];
+        logger.info << string(2 + 2 * r.depth, ' ') << r.name << ": "
+                    << r.duration / 1000 << " (" << r.peakMemory << ", "
+                    << r.allocations << ", " << r.allocatedBytes / 1024 << ")"
+                    << logger.end;
+    }
+    if (!reportFile.empty())
+        WriteReport(reportFile);
+}
+
+const vector<StartupProfiler::Record>& StartupProfiler::GetRecords() const {
+    return records;
+}
+
+// Peak resident set size in kb, 0 where it is not available
+unsigned long StartupProfiler::GetPeakMemory() {
+#ifdef _WIN32
+    return 0;
+#else
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) return 0;
+#ifdef __APPLE__
+    return usage.ru_maxrss / 1024;
+#else
+    return usage.ru_maxrss;
+#endif
+#endif
+}
+
+bool StartupProfiler::WriteReport(string file) const {
+    ofstream out(file.c_str());
+    if (!out.is_open()) {
+        logger.error << "Can not open '" << file << "' for output" << logger.end;
+        return false;
+    }
+    unsigned int total = 0;
+    for (unsigned int i = 0; i < records.size(); i++)
+        if (records[i].depth == 0 && records[i].category == "phase")
+            total += records[i].duration;
+    out << "{\"total_us\":" << total << "," << std::endl
+        << "\"peak_memory_kb\":" << GetPeakMemory() << "," << std::endl
+        << "\"records\":[" << std::endl;
+    for (unsigned int i = 0; i < records.size(); i++) {
+        const Record& r = records[i];
+        out << "{\"name\":" << Quote(r.name) << ","
+            << "\"category\":" << Quote(r.category) << ","
+            << "\"depth\":" << r.depth << ","
+            << "\"start_us\":" << r.start << ","
+            << "\"duration_us\":" << r.duration << ","
+            << "\"peak_memory_kb\":" << r.peakMemory << ","
+            << "\"allocations\":" << r.allocations << ","
+            << "\"allocated_bytes\":" << r.allocatedBytes << "}"
+            << (i + 1 < records.size() ? "," : "") << std::endl;
+    }
+    out << "]}" << std::endl;
+    logger.info << "Saved startup report to '" << file << "'" << logger.end;
+    return out.good();
+}
@@ -0,0 +1,114 @@
+// Wall time and memory of the startup phases.
+// -------------------------------------------------------------------
+// Copyright (C) 2007 OpenEngine.dk (See AUTHORS)
+//
+// This program is free software; It is covered by the GNU General
+// Public License version 2 or any later version.
+// See the GNU General Public License for more details (see LICENSE).
+//--------------------------------------------------------------------
+
+#ifndef _STARTUP_PROFILER_
+#define _STARTUP_PROFILER_
+
+#include <Core/IListener.h>
+#include <Core/IEvent.h>
+#include <Core/EngineEvents.h>
+#include <Utils/Timer.h>
+
+#include "SceneArena.h"
+
+#include <string>
+#include <vector>
+
+using OpenEngine::Core::IListener;
+using OpenEngine::Core::IEvent;
+using OpenEngine::Core::InitializeEventArg;
+using OpenEngine::Utils::Timer;
+using std::string;
+using std::vector;
+
+/**
+ * Records how long each startup phase takes.
+ *
+ * Phases are timed with Begin and End and may nest. Work that was
+ * timed elsewhere, such as models loaded on worker threads, is added
+ * with Add. Listeners of initialize events are timed by attaching
+ * them through the profiler. Every record also keeps the peak
+ * resident memory of the process at its end, where the platform
+ * reports it, and the number and size of the allocations made by
+ * all threads while the phase was open.
+ *
+ * The profiler must be attached last to the engine initialize event.
+ * It then closes the open phases, logs the records and writes them
+ * as JSON if a report file is set.
+ */
+class StartupProfiler : public IListener<InitializeEventArg> {
+public:
+    struct Record {
+        string name;
+        string category;
+        unsigned int depth;
+        unsigned int start;       // usec since the profiler was created
+        unsigned int duration;    // usec
+        unsigned long peakMemory; // kb, 0 if unknown
+        unsigned long allocations;
+        unsigned long allocatedBytes;
+    };
+
+private:
+    class ProxyBase {
+    public:
+        virtual ~ProxyBase() {}
+    };
+
+    template <class T>
+    class Proxy : public IListener<T>, public ProxyBase {
+    private:
+        StartupProfiler& profiler;
+        IListener<T>& listener;
+        string name;
+    public:
+        Proxy(StartupProfiler& profiler, IListener<T>& listener, string name)
+            : profiler(profiler), listener(listener), name(name) {}
+        void Handle(T arg) {
+            profiler.Begin(name, "initialize");
+            listener.Handle(arg);
+            profiler.End();
+        }
+    };
+
+    Timer timer;
+    vector<Record> records;
+    vector<unsigned int> open;
+    vector<SceneArena::Counters> openCounters;
+    vector<ProxyBase*> proxies;
+    string reportFile;
+
+    bool WriteReport(string file) const;
+
+public:
+    StartupProfiler();
+    ~StartupProfiler();
+
+    void Begin(string name, string category = "phase");
+    void End();
+    void Add(string name, string category, unsigned int duration);
+    void Add(string name, string category, unsigned int duration,
+             unsigned int start);
+    unsigned int GetTime();
+
+    template <class T>
+    void Attach(IEvent<T>& event, IListener<T>& listener, string name) {
+        Proxy<T>* proxy = new Proxy<T>(*this, listener, name);
+        proxies.push_back(proxy);
+        event.Attach(*proxy);
+    }
+
+    void SetReportFile(string file);
+    void Handle(InitializeEventArg arg);
+
+    const vector<Record>& GetRecords() const;
+    static unsigned long GetPeakMemory();
+};
+
+#endif
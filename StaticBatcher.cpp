@@ -0,0 +1,340 @@
+#include "StaticBatcher.h"
+#include "IndexedBatchNode.h"
+
+#include <Geometry/FaceSet.h>
+#include <Geometry/Material.h>
+#include <Logging/Logger.h>
+#include <Scene/GeometryNode.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <map>
+
+using OpenEngine::Geometry::FaceSet;
+using OpenEngine::Geometry::FaceList;
+using OpenEngine::Geometry::MaterialPtr;
+using OpenEngine::Scene::GeometryNode;
+using std::map;
+
+namespace {
+
+// Vertices in the cache as seen by the optimizer's scoring
+const unsigned int SCORE_CACHE = 32;
+
+// The faces of one material, drawn with a single call
+struct Draw {
+    MaterialPtr mat;
+    vector<FacePtr> faces;
+};
+
+// Faces are grouped on the material object they point to, as the
+// vertex array transformer does
+void AddFace(vector<Draw>& draws, const FacePtr& face) {
+    for (unsigned int i = 0; i < draws.size(); i++)
+        if (draws[i].mat == face->mat) {
+            draws[i].faces.push_back(face);
+            return;
+        }
+    Draw d;
+    d.mat = face->mat;
+    d.faces.push_back(face);
+    draws.push_back(d);
+}
+
+// A corner of a face in the GL_T2F_C4F_N3F_V3F layout
+struct Vertex {
+    float v[IndexedBatchNode::VERTEX_SIZE];
+    bool operator<(const Vertex& o) const {
+        return memcmp(v, o.v, sizeof(v)) < 0;
+    }
+};
+
+Vertex VertexOf(const FacePtr& f, int k) {
+    Vertex x;
+    x.v[0] = f->texc[k][0];
+    x.v[1] = f->texc[k][1];
+    for (int i = 0; i < 4; i++)
+        x.v[2 + i] = f->colr[k][i];
+    for (int i = 0; i < 3; i++) {
+        x.v[6 + i] = f->norm[k][i];
+        x.v[9 + i] = f->vert[k][i];
+    }
+    return x;
+}
+
+// Nodes holding geometry nodes directly, that is the quad cells
+void CollectCells(ISceneNode* node, vector<ISceneNode*>& cells) {
+    bool cell = false;
+    for (unsigned int i = 0; i < node->GetNumberOfNodes(); i++) {
+        ISceneNode* child = node->GetNode(i);
+        if (dynamic_cast<GeometryNode*>(child) != NULL)
+            cell = true;
+        else
+            CollectCells(child, cells);
+    }
+    if (cell) cells.push_back(node);
+}
+
+// Score of a vertex from its position in the cache and the number
+// of triangles still to be drawn using it
+float VertexScore(int position, unsigned int remaining) {
+    if (remaining == 0) return -1;
+    float score = 0;
+    if (position >= 3)
+        score = pow(1 - (position - 3) / (float)(SCORE_CACHE - 3), 1.5f);
+    else if (position >= 0)
+        score = 0.75f;
+    return score + 2.0f / sqrt((float)remaining);
+}
+
+} // anonymous namespace
+
+StaticBatcher::StaticBatcher()
+    : cells(0)
+    , drawsBefore(0)
+    , drawsAfter(0)
+    , faces(0)
+    , vertices(0)
+    , missesIndexed(0)
+    , missesAfter(0)
+{}
+
+void StaticBatcher::Batch(ISceneNode& scene,
+                          const vector<ISceneNode*>& detached) {
+    vector<ISceneNode*> cellNodes;
+    CollectCells(&scene, cellNodes);
+    for (unsigned int i = 0; i < detached.size(); i++)
+        CollectCells(detached[i], cellNodes);
+    for (unsigned int c = 0; c < cellNodes.size(); c++)
+        BatchCell(cellNodes[c]);
+
+    logger.info << "Batched " << faces << " static faces in " << cells
+                << " cells: " << drawsBefore << " draws before, "
+                << drawsAfter << " indexed draws of " << vertices
+                << " vertices after, ACMR " << GetACMRBefore()
+                << " before (arrays without indices), "
+                << GetACMRIndexed() << " indexed in the loaded order, "
+                << GetACMRAfter() << " reordered (FIFO " << FIFO_SIZE
+                << ")" << logger.end;
+}
+
+// Replaces the geometry nodes of a cell by an indexed batch per
+// material
+void StaticBatcher::BatchCell(ISceneNode* cell) {
+    vector<GeometryNode*> geoms;
+    for (unsigned int i = 0; i < cell->GetNumberOfNodes(); i++) {
+        GeometryNode* geom = dynamic_cast<GeometryNode*>(cell->GetNode(i));
+        if (geom != NULL && geom->GetFaceSet() != NULL)
+            geoms.push_back(geom);
+    }
+
+    // The draws as the vertex array transformer would make them, and
+    // the faces of the cell grouped by material
+    vector<Draw> batches;
+    for (unsigned int g = 0; g < geoms.size(); g++) {
+        FaceSet* fs = geoms[g]->GetFaceSet();
+        vector<Draw> draws;
+        for (FaceList::iterator itr = fs->begin(); itr != fs->end(); itr++) {
+            AddFace(draws, *itr);
+            AddFace(batches, *itr);
+        }
+        drawsBefore += draws.size();
+        faces += fs->Size();
+    }
+
+    vector<unsigned int> indices, order, reordered, remap;
+    vector<float> data, arranged;
+    for (unsigned int b = 0; b < batches.size(); b++) {
+        const unsigned int count = Index(batches[b].faces, indices, &data);
+        missesIndexed += CountMisses(indices);
+        Optimize(indices, count, order);
+
+        // Triangles in the optimized order, and the vertices in the
+        // order they are first used so the fetches run forward
+        remap.assign(count, count);
+        reordered.clear();
+        arranged.clear();
+        for (unsigned int t = 0; t < order.size(); t++)
+            for (int k = 0; k < 3; k++) {
+                unsigned int v = indices[order[t] * 3 + k];
+                if (remap[v] == count) {
+                    remap[v] = arranged.size() / IndexedBatchNode::VERTEX_SIZE;
+                    arranged.insert(arranged.end(),
+                                    data.begin() + v * IndexedBatchNode::VERTEX_SIZE,
+                                    data.begin() + (v + 1) * IndexedBatchNode::VERTEX_SIZE);
+                }
+                reordered.push_back(remap[v]);
+            }
+        missesAfter += CountMisses(reordered);
+        vertices += count;
+        cell->AddNode(new IndexedBatchNode(batches[b].mat, arranged, reordered));
+    }
+    drawsAfter += batches.size();
+
+    for (unsigned int g = 0; g < geoms.size(); g++) {
+        cell->RemoveNode(geoms[g]);
+        delete geoms[g];
+    }
+    cells++;
+}
+
+// Indices of the face corners into the distinct vertices, returns the
+// number of distinct vertices. With vertices the distinct vertices are
+// stored there in the GL_T2F_C4F_N3F_V3F layout.
+unsigned int StaticBatcher::Index(const vector<FacePtr>& faces,
+                                  vector<unsigned int>& indices,
+                                  vector<float>* vertices) {
+    map<Vertex, unsigned int> ids;
+    indices.clear();
+    indices.reserve(faces.size() * 3);
+    if (vertices != NULL) vertices->clear();
+    for (unsigned int f = 0; f < faces.size(); f++)
+        for (int k = 0; k < 3; k++) {
+            Vertex x = VertexOf(faces[f], k);
+            unsigned int id = ids.size();
+            std::pair<map<Vertex, unsigned int>::iterator, bool> r =
+                ids.insert(std::make_pair(x, id));
+            if (r.second && vertices != NULL)
+                vertices->insert(vertices->end(), x.v,
+                                 x.v + IndexedBatchNode::VERTEX_SIZE);
+            indices.push_back(r.first->second);
+        }
+    return ids.size();
+}
+
+// Forsyth's greedy ordering. Each step adds the best scoring triangle
+// using a vertex in the cache, falling back to the first triangle not
+// added yet when none is left there. Order receives the triangles in
+// their new order.
+void StaticBatcher::Optimize(const vector<unsigned int>& indices,
+                             unsigned int vertexCount,
+                             vector<unsigned int>& order) {
+    const unsigned int triangles = indices.size() / 3;
+    order.clear();
+    order.reserve(triangles);
+
+    // The triangles still to be added using each vertex, as ranges of
+    // one array
+    vector<unsigned int> remaining(vertexCount, 0);
+    for (unsigned int i = 0; i < indices.size(); i++)
+        remaining[indices[i]]++;
+    vector<unsigned int> first(vertexCount + 1, 0);
+    for (unsigned int v = 0; v < vertexCount; v++)
+        first[v + 1] = first[v] + remaining[v];
+    vector<unsigned int> adjacent(indices.size());
+    vector<unsigned int> fill(first.begin(), first.end() - 1);
+    for (unsigned int i = 0; i < indices.size(); i++)
+        adjacent[fill[indices[i]]++] = i / 3;
+
+    vector<int> position(vertexCount, -1);
+    vector<float> vertexScore(vertexCount);
+    for (unsigned int v = 0; v < vertexCount; v++)
+        vertexScore[v] = VertexScore(-1, remaining[v]);
+    vector<bool> added(triangles, false);
+
+    vector<unsigned int> cache, next;
+    unsigned int scan = 0;
+    int best = -1;
+    while (order.size() < triangles) {
+        if (best < 0) {
+            while (added[scan]) scan++;
+            best = scan;
+        }
+        added[best] = true;
+        order.push_back(best);
+
+        // The corners go to the front of the cache and lose the
+        // triangle from their lists
+        next.clear();
+        for (int k = 0; k < 3; k++) {
+            unsigned int v = indices[best * 3 + k];
+            unsigned int* list = &adjacent[first[v]];
+            for (unsigned int i = 0; i < remaining[v]; i++)
+                if (list[i] == (unsigned int)best) {
+                    list[i] = list[--remaining[v]];
+                    break;
+                }
+            if (std::find(next.begin(), next.end(), v) == next.end())
+                next.push_back(v);
+        }
+        const unsigned int corners = next.size();
+        for (unsigned int i = 0; i < cache.size(); i++)
+            if (std::find(next.begin(), next.begin() + corners,
+                          cache[i]) == next.begin() + corners)
+                next.push_back(cache[i]);
+
+        // Rescore the vertices in the cache and those pushed out of
+        // it, and pick the best triangle of the cached vertices
+        for (unsigned int i = 0; i < next.size(); i++) {
+            unsigned int v = next[i];
+            position[v] = i < SCORE_CACHE ? (int)i : -1;
+            vertexScore[v] = VertexScore(position[v], remaining[v]);
+        }
+        best = -1;
+        float bestScore = -1;
+        for (unsigned int i = 0; i < next.size(); i++) {
+            unsigned int v = next[i];
+            const unsigned int* list = &adjacent[first[v]];
+            for (unsigned int j = 0; j < remaining[v]; j++) {
+                unsigned int t = list[j];
+                float score = vertexScore[indices[t * 3]] +
+                    vertexScore[indices[t * 3 + 1]] +
+                    vertexScore[indices[t * 3 + 2]];
+                if (i < SCORE_CACHE && score > bestScore) {
+                    best = t;
+                    bestScore = score;
+                }
+            }
+        }
+        if (next.size() > SCORE_CACHE)
+            next.resize(SCORE_CACHE);
+        cache.swap(next);
+    }
+}
+
+// Vertex cache misses of an indexed triangle list drawn through a
+// FIFO cache of the given size
+unsigned int StaticBatcher::CountMisses(const vector<unsigned int>& indices,
+                                        unsigned int cacheSize) {
+    map<unsigned int, unsigned int> loaded;
+    unsigned int misses = 0;
+    for (unsigned int i = 0; i < indices.size(); i++) {
+        map<unsigned int, unsigned int>::iterator itr = loaded.find(indices[i]);
+        if (itr != loaded.end() && misses - itr->second < cacheSize)
+            continue;
+        loaded[indices[i]] = misses;
+        misses++;
+    }
+    return misses;
+}
+
+unsigned int StaticBatcher::GetCellCount() const {
+    return cells;
+}
+
+unsigned long StaticBatcher::GetFaceCount() const {
+    return faces;
+}
+
+unsigned int StaticBatcher::GetDrawsBefore() const {
+    return drawsBefore;
+}
+
+unsigned int StaticBatcher::GetDrawsAfter() const {
+    return drawsAfter;
+}
+
+// The vertex arrays are drawn without indices, so every corner is
+// transformed
+float StaticBatcher::GetACMRBefore() const {
+    return faces ? 3.0f : 0;
+}
+
+float StaticBatcher::GetACMRIndexed() const {
+    return faces ? (float)missesIndexed / faces : 0;
+}
+
+float StaticBatcher::GetACMRAfter() const {
+    return faces ? (float)missesAfter / faces : 0;
+}
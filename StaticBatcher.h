@@ -0,0 +1,83 @@
+// Material batching and vertex cache ordering of the static scene.
+// -------------------------------------------------------------------
+// Copyright (C) 2007 OpenEngine.dk (See AUTHORS)
+//
+// This program is free software; It is covered by the GNU General
+// Public License version 2 or any later version.
+// See the GNU General Public License for more details (see LICENSE).
+//--------------------------------------------------------------------
+
+#ifndef _STATIC_BATCHER_
+#define _STATIC_BATCHER_
+
+#include <Geometry/Face.h>
+#include <Scene/ISceneNode.h>
+
+#include <vector>
+
+using OpenEngine::Geometry::FacePtr;
+using OpenEngine::Scene::ISceneNode;
+using std::vector;
+
+/**
+ * Merges the geometry of each static quad cell into one indexed
+ * batch per material and orders its triangles for the post-transform
+ * vertex cache.
+ *
+ * The vertex array transformer makes a set of arrays, and so a draw
+ * call, per material of every geometry node, and draws them without
+ * indices. After batching a cell holds a single IndexedBatchNode per
+ * material in place of its geometry nodes, so the cell is drawn with
+ * one indexed call per material. Only faces sharing the same
+ * material object are merged.
+ *
+ * The faces of a batch are indexed on their distinct vertices
+ * (texture coordinate, color, normal and position), reordered with
+ * Forsyth's linear speed vertex cache optimization and the vertices
+ * laid out in the order they are first used. Draw calls and the
+ * average cache miss ratio (cache misses per triangle) of a
+ * simulated FIFO vertex cache are counted on the CPU: 3 before, as
+ * the vertex arrays transform every corner, then for the indexed
+ * batch in the loaded order and after reordering.
+ *
+ * Cells are found as the nodes holding geometry nodes directly, so
+ * after the LODSelector each level of detail is batched on its own;
+ * the levels not in the scene are passed as detached.
+ */
+class StaticBatcher {
+public:
+    static const unsigned int FIFO_SIZE = 16;
+
+private:
+    unsigned int cells;
+    unsigned int drawsBefore, drawsAfter;
+    unsigned long faces, vertices;
+    unsigned long missesIndexed, missesAfter;
+
+    void BatchCell(ISceneNode* cell);
+
+public:
+    StaticBatcher();
+
+    void Batch(ISceneNode& scene,
+               const vector<ISceneNode*>& detached = vector<ISceneNode*>());
+
+    static unsigned int Index(const vector<FacePtr>& faces,
+                              vector<unsigned int>& indices,
+                              vector<float>* vertices = NULL);
+    static void Optimize(const vector<unsigned int>& indices,
+                         unsigned int vertexCount,
+                         vector<unsigned int>& order);
+    static unsigned int CountMisses(const vector<unsigned int>& indices,
+                                    unsigned int cacheSize = FIFO_SIZE);
+
+    unsigned int GetCellCount() const;
+    unsigned long GetFaceCount() const;
+    unsigned int GetDrawsBefore() const;
+    unsigned int GetDrawsAfter() const;
+    float GetACMRBefore() const;
+    float GetACMRIndexed() const;
+    float GetACMRAfter() const;
+};
+
+#endif
@@ -0,0 +1,163 @@
+#include "TaskScheduler.h"
+#include "LockFree.h"
+
+#include <Logging/Logger.h>
+
+namespace {
+// Empty polls before an idle worker starts sleeping between them
+const unsigned int IDLE_SPINS = 1000;
+}
+
+TaskScheduler::Worker::Worker(TaskScheduler& scheduler, unsigned int index)
+    : scheduler(scheduler)
+    , index(index) {}
+
+void TaskScheduler::Worker::Run() {
+    unsigned int idle = 0;
+    while (scheduler.running) {
+        if (scheduler.RunOne(index))
+            idle = 0;
+        else if (++idle > IDLE_SPINS)
+            Thread::Sleep(100);
+    }
+}
+
+TaskScheduler::TaskScheduler(unsigned int threads)
+    : threads(threads)
+    , frameArg(NULL)
+    , remaining(0)
+    , running(false)
+    , frames(0)
+    , frameTime(0)
+    , steals(0)
+{
+    for (unsigned int i = 0; i <= threads; i++)
+        queues.push_back(new Queue());
+}
+
+TaskScheduler::~TaskScheduler() {
+    for (unsigned int i = 0; i < queues.size(); i++)
+        delete queues[i];
+    for (unsigned int i = 0; i < workers.size(); i++)
+        delete workers[i];
+}
+
+unsigned int TaskScheduler::Add(IListener<ProcessEventArg>& listener,
+                                string name,
+                                unsigned int reads, unsigned int writes) {
+    Task t;
+    t.listener = &listener;
+    t.name = name;
+    t.reads = reads;
+    t.writes = writes;
+    t.dependencies = 0;
+    t.pending = 0;
+    unsigned int index = tasks.size();
+    for (unsigned int i = 0; i < tasks.size(); i++) {
+        if ((tasks[i].writes & (reads | writes)) == 0 &&
+            (tasks[i].reads & writes) == 0) continue;
+        tasks[i].dependents.push_back(index);
+        t.dependencies++;
+    }
+    tasks.push_back(t);
+    return index;
+}
+
+unsigned int TaskScheduler::GetTaskCount() const {
+    return tasks.size();
+}
+
+unsigned int TaskScheduler::GetThreadCount() const {
+    return threads;
+}
+
+void TaskScheduler::Push(unsigned int task, unsigned int queue) {
+    Queue& q = (tasks[task].writes & DISPLAY) ? mainQueue : *queues[queue];
+    q.lock.Lock();
+    q.tasks.push_back(task);
+    q.lock.Unlock();
+}
+
+bool TaskScheduler::Pop(Queue& queue, bool newest, unsigned int& task) {
+    queue.lock.Lock();
+    bool found = !queue.tasks.empty();
+    if (found && newest) {
+        task = queue.tasks.back();
+        queue.tasks.pop_back();
+    } else if (found) {
+        task = queue.tasks.front();
+        queue.tasks.pop_front();
+    }
+    queue.lock.Unlock();
+    return found;
+}
+
+// Runs one ready task from the queue of the calling thread or stolen
+// from another, and releases the tasks waiting for it.
+bool TaskScheduler::RunOne(unsigned int queue) {
+    unsigned int task;
+    bool found = (queue == 0 && Pop(mainQueue, false, task)) ||
+        Pop(*queues[queue], true, task);
+    for (unsigned int i = 1; !found && i < queues.size(); i++) {
+        found = Pop(*queues[(queue + i) % queues.size()], false, task);
+        if (found) LOCKFREE_ADD(&steals, 1);
+    }
+    if (!found) return false;
+
+    Task& t = tasks[task];
+    t.listener->Handle(*frameArg);
+    for (unsigned int i = 0; i < t.dependents.size(); i++) {
+        unsigned int d = t.dependents[i];
+        if (LOCKFREE_ADD(&tasks[d].pending, -1) == 0)
+            Push(d, queue);
+    }
+    LOCKFREE_ADD(&remaining, -1);
+    return true;
+}
+
+void TaskScheduler::Handle(InitializeEventArg arg) {
+    frames = 0;
+    frameTime = 0;
+    steals = 0;
+    running = true;
+    for (unsigned int i = 1; i <= threads; i++) {
+        workers.push_back(new Worker(*this, i));
+        workers.back()->Start();
+    }
+}
+
+void TaskScheduler::Handle(ProcessEventArg arg) {
+    if (tasks.empty()) return;
+    timer.Reset();
+    timer.Start();
+
+    frameArg = &arg;
+    for (unsigned int i = 0; i < tasks.size(); i++)
+        tasks[i].pending = tasks[i].dependencies;
+    remaining = tasks.size();
+    LOCKFREE_BARRIER();
+    for (unsigned int i = 0; i < tasks.size(); i++)
+        if (tasks[i].dependencies == 0) Push(i, 0);
+
+    // The engine thread works on the frame too
+    while (remaining > 0)
+        RunOne(0);
+    LOCKFREE_BARRIER();
+
+    frameTime += timer.GetElapsedTime().AsInt();
+    frames++;
+}
+
+void TaskScheduler::Handle(DeinitializeEventArg arg) {
+    running = false;
+    for (unsigned int i = 0; i < workers.size(); i++) {
+        workers[i]->Wait();
+        delete workers[i];
+    }
+    workers.clear();
+    if (frames == 0) return;
+    logger.info << "Task scheduler: " << tasks.size() << " tasks on "
+                << threads + 1 << " threads, "
+                << (float)frameTime / frames << " usec/frame, "
+                << steals << " steals" << logger.end;
+}
@@ -0,0 +1,122 @@
+// Parallel task graph of the process event listeners.
+// -------------------------------------------------------------------
+// Copyright (C) 2007 OpenEngine.dk (See AUTHORS)
+//
+// This program is free software; It is covered by the GNU General
+// Public License version 2 or any later version.
+// See the GNU General Public License for more details (see LICENSE).
+//--------------------------------------------------------------------
+
+#ifndef _TASK_SCHEDULER_
+#define _TASK_SCHEDULER_
+
+#include <Core/IModule.h>
+#include <Core/Mutex.h>
+#include <Core/Thread.h>
+#include <Utils/Timer.h>
+
+#include <deque>
+#include <string>
+#include <vector>
+
+using OpenEngine::Core::IModule;
+using OpenEngine::Core::IListener;
+using OpenEngine::Core::Mutex;
+using OpenEngine::Core::Thread;
+using OpenEngine::Core::InitializeEventArg;
+using OpenEngine::Core::ProcessEventArg;
+using OpenEngine::Core::DeinitializeEventArg;
+using OpenEngine::Utils::Timer;
+using std::deque;
+using std::string;
+using std::vector;
+
+/**
+ * Runs the process event listeners of a frame as a task graph on a
+ * pool of worker threads.
+ *
+ * Each listener is added with the shared state it reads and writes.
+ * A task depends on every task added before it that writes what it
+ * reads or writes, or reads what it writes, so conflicting modules
+ * keep their attach order and independent ones overlap. Tasks using
+ * the display run on the engine thread, which owns the window and
+ * the GL context; a task added without resources uses everything
+ * and runs alone on the engine thread.
+ *
+ * Every thread, the engine thread included, has a queue of ready
+ * tasks. A thread runs the newest task of its own queue and, when it
+ * is empty, steals the oldest task from another queue. Process
+ * returns when every task of the frame has run.
+ */
+class TaskScheduler : public IModule {
+public:
+    enum Resource {
+        INPUT   = 1 << 0,   // device state and input events
+        CAMERA  = 1 << 1,   // camera and frustum
+        VEHICLE = 1 << 2,   // physics, rigid box and vehicle node
+        TRAFFIC = 1 << 3,   // AI vehicles and their nodes
+        SCENE   = 1 << 4,   // static scene structure
+        HUD     = 1 << 5,   // HUD panel and surface
+        LOG     = 1 << 6,   // logger output
+        DISPLAY = 1 << 7,   // window and GL context
+        ALL     = 0xff
+    };
+
+private:
+    struct Task {
+        IListener<ProcessEventArg>* listener;
+        string name;
+        unsigned int reads, writes;
+        vector<unsigned int> dependents;
+        unsigned int dependencies;
+        volatile int pending;
+    };
+
+    struct Queue {
+        Mutex lock;
+        deque<unsigned int> tasks;
+    };
+
+    class Worker : public Thread {
+    private:
+        TaskScheduler& scheduler;
+        unsigned int index;
+    public:
+        Worker(TaskScheduler& scheduler, unsigned int index);
+        void Run();
+    };
+    friend class Worker;
+
+    vector<Task> tasks;
+    vector<Queue*> queues;        // 0 is the engine thread
+    Queue mainQueue;              // tasks for the engine thread only
+    vector<Worker*> workers;
+    unsigned int threads;
+    const ProcessEventArg* frameArg;
+    volatile int remaining;
+    volatile bool running;
+    unsigned int frames;
+    unsigned long long frameTime;
+    volatile int steals;
+    Timer timer;
+
+    void Push(unsigned int task, unsigned int queue);
+    bool Pop(Queue& queue, bool newest, unsigned int& task);
+    bool RunOne(unsigned int queue);
+
+public:
+    TaskScheduler(unsigned int threads);
+    ~TaskScheduler();
+
+    unsigned int Add(IListener<ProcessEventArg>& listener, string name,
+                     unsigned int reads = ALL, unsigned int writes = ALL);
+
+    unsigned int GetTaskCount() const;
+    unsigned int GetThreadCount() const;
+
+    void Handle(InitializeEventArg arg);
+    void Handle(ProcessEventArg arg);
+    void Handle(DeinitializeEventArg arg);
+};
+
+#endif
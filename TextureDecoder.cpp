@@ -0,0 +1,60 @@
+#include "TextureDecoder.h"
+
+#include <algorithm>
+
+// Loads the texture through its resource plugin and copies out the
+// pixels, so the resource can be unloaded right away. Textures that
+// were loaded already stay loaded.
+bool TextureDecoder::Decode(ITextureResourcePtr texture, DecodedImage& image) {
+    bool loaded = texture->GetData() != NULL;
+    if (!loaded) texture->Load();
+    unsigned char* data = texture->GetData();
+    unsigned int channels = texture->GetDepth() / 8;
+    if (data == NULL || channels == 0 || channels > 4) {
+        if (!loaded) texture->Unload();
+        return false;
+    }
+
+    MipLevel level;
+    level.width = texture->GetWidth();
+    level.height = texture->GetHeight();
+    level.pixels.assign(data, data + level.width * level.height * channels);
+    image.channels = channels;
+    image.levels.clear();
+    image.levels.push_back(level);
+
+    if (!loaded) texture->Unload();
+    return true;
+}
+
+// Box filtered mipmap chain down to 1x1. Odd sizes clamp the last
+// row and column, so any size works.
+void TextureDecoder::BuildMipmaps(DecodedImage& image) {
+    if (image.levels.empty()) return;
+    image.levels.resize(1);
+    const unsigned int c = image.channels;
+    while (image.levels.back().width > 1 || image.levels.back().height > 1) {
+        const MipLevel& src = image.levels.back();
+        MipLevel dst;
+        dst.width = std::max(src.width / 2, 1u);
+        dst.height = std::max(src.height / 2, 1u);
+        dst.pixels.resize(dst.width * dst.height * c);
+        for (unsigned int y = 0; y < dst.height; y++) {
+            unsigned int y0 = std::min(2 * y, src.height - 1);
+            unsigned int y1 = std::min(2 * y + 1, src.height - 1);
+            for (unsigned int x = 0; x < dst.width; x++) {
+                unsigned int x0 = std::min(2 * x, src.width - 1);
+                unsigned int x1 = std::min(2 * x + 1, src.width - 1);
+                for (unsigned int k = 0; k < c; k++) {
+                    unsigned int sum =
+                        src.pixels[(y0 * src.width + x0) * c + k] +
+                        src.pixels[(y0 * src.width + x1) * c + k] +
+                        src.pixels[(y1 * src.width + x0) * c + k] +
+                        src.pixels[(y1 * src.width + x1) * c + k];
+                    dst.pixels[(y * dst.width + x) * c + k] = (sum + 2) / 4;
+                }
+            }
+        }
+        image.levels.push_back(dst);
+    }
+}
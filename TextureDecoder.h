@@ -0,0 +1,48 @@
+// CPU side texture decoding and mipmap generation.
+// -------------------------------------------------------------------
+// Copyright (C) 2007 OpenEngine.dk (See AUTHORS)
+//
+// This program is free software; It is covered by the GNU General
+// Public License version 2 or any later version.
+// See the GNU General Public License for more details (see LICENSE).
+//--------------------------------------------------------------------
+
+#ifndef _TEXTURE_DECODER_
+#define _TEXTURE_DECODER_
+
+#include <Resources/ITextureResource.h>
+
+#include <vector>
+
+using OpenEngine::Resources::ITextureResourcePtr;
+using std::vector;
+
+/**
+ * One mipmap level of a decoded image.
+ */
+struct MipLevel {
+    unsigned int width, height;
+    vector<unsigned char> pixels;
+};
+
+/**
+ * A decoded image with its full mipmap chain, level 0 first.
+ * Channels is the number of bytes per pixel (1, 3 or 4).
+ */
+struct DecodedImage {
+    unsigned int channels;
+    vector<MipLevel> levels;
+};
+
+/**
+ * The decode and mipmap stages of the texture pipeline. Neither
+ * touches OpenGL, so both run on worker threads and outside of a
+ * rendering context.
+ */
+class TextureDecoder {
+public:
+    static bool Decode(ITextureResourcePtr texture, DecodedImage& image);
+    static void BuildMipmaps(DecodedImage& image);
+};
+
+#endif
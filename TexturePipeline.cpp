@@ -0,0 +1,201 @@
+#include <Meta/OpenGL.h>
+
+#include "TexturePipeline.h"
+
+#include <Geometry/FaceSet.h>
+#include <Geometry/Material.h>
+#include <Logging/Logger.h>
+#include <Scene/GeometryNode.h>
+
+using OpenEngine::Geometry::FaceList;
+using OpenEngine::Geometry::FaceSet;
+using OpenEngine::Scene::GeometryNode;
+
+TexturePipeline::Initializer::Initializer(TexturePipeline& pipeline)
+    : pipeline(pipeline) {}
+
+void TexturePipeline::Initializer::Handle(RenderingEventArg arg) {
+    pipeline.Start();
+}
+
+TexturePipeline::Uploader::Uploader(TexturePipeline& pipeline)
+    : pipeline(pipeline) {}
+
+void TexturePipeline::Uploader::Handle(RenderingEventArg arg) {
+    pipeline.Upload();
+}
+
+TexturePipeline::Worker::Worker(TexturePipeline& pipeline)
+    : pipeline(pipeline) {}
+
+TexturePipeline::Stopper::Stopper(TexturePipeline& pipeline)
+    : pipeline(pipeline) {}
+
+// No new jobs are taken after this, the running ones are waited for
+void TexturePipeline::Stopper::Handle(DeinitializeEventArg arg) {
+    pipeline.lock.Lock();
+    pipeline.nextJob = pipeline.jobs.size();
+    pipeline.lock.Unlock();
+    pipeline.Finish();
+}
+
+void TexturePipeline::Worker::Run() {
+    for (;;) {
+        pipeline.lock.Lock();
+        unsigned int next = pipeline.nextJob++;
+        pipeline.lock.Unlock();
+        if (next >= pipeline.jobs.size()) return;
+
+        Job* job = pipeline.jobs[next];
+        job->decoded = TextureDecoder::Decode(job->texture, job->image);
+        if (job->decoded)
+            TextureDecoder::BuildMipmaps(job->image);
+
+        pipeline.lock.Lock();
+        pipeline.ready.push_back(job);
+        pipeline.lock.Unlock();
+    }
+}
+
+TexturePipeline::TexturePipeline(ISceneNode* scene, unsigned int threads)
+    : threads(threads)
+    , uploadBudget(4 * 1024 * 1024)
+    , initializer(*this)
+    , uploader(*this)
+    , stopper(*this)
+    , nextJob(0)
+    , uploaded(0)
+{
+    set<ITextureResource*> seen;
+    Collect(scene, seen);
+}
+
+TexturePipeline::~TexturePipeline() {
+    Finish();
+    for (unsigned int i = 0; i < jobs.size(); i++)
+        delete jobs[i];
+}
+
+IListener<RenderingEventArg>& TexturePipeline::InitializeListener() {
+    return initializer;
+}
+
+IListener<RenderingEventArg>& TexturePipeline::ProcessListener() {
+    return uploader;
+}
+
+IListener<DeinitializeEventArg>& TexturePipeline::DeinitializeListener() {
+    return stopper;
+}
+
+void TexturePipeline::SetUploadBudget(unsigned int bytes) {
+    uploadBudget = bytes;
+}
+
+unsigned int TexturePipeline::GetTextureCount() const {
+    return jobs.size();
+}
+
+unsigned int TexturePipeline::GetUploadedCount() const {
+    return uploaded;
+}
+
+// Adds a job for every texture of the subtree that has no texture id
+void TexturePipeline::Collect(ISceneNode* node, set<ITextureResource*>& seen) {
+    GeometryNode* geom = dynamic_cast<GeometryNode*>(node);
+    if (geom != NULL && geom->GetFaceSet() != NULL) {
+        FaceSet* fs = geom->GetFaceSet();
+        for (FaceList::iterator itr = fs->begin(); itr != fs->end(); itr++) {
+            if ((*itr)->mat.get() == NULL) continue;
+            ITextureResourcePtr texr = (*itr)->mat->texr;
+            if (texr.get() == NULL || texr->GetID() != 0) continue;
+            if (!seen.insert(texr.get()).second) continue;
+            Job* job = new Job();
+            job->texture = texr;
+            job->decoded = false;
+            jobs.push_back(job);
+        }
+    }
+    for (unsigned int i = 0; i < node->GetNumberOfNodes(); i++)
+        Collect(node->GetNode(i), seen);
+}
+
+// Runs in the rendering context: placeholders first, then the workers
+void TexturePipeline::Start() {
+    timer.Start();
+
+    const unsigned char grey[4] = { 128, 128, 128, 255 };
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    for (unsigned int i = 0; i < jobs.size(); i++) {
+        GLuint id;
+        glGenTextures(1, &id);
+        glBindTexture(GL_TEXTURE_2D, id);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 1, 1, 0,
+                     GL_RGBA, GL_UNSIGNED_BYTE, grey);
+        jobs[i]->texture->SetID(id);
+    }
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    unsigned int count = threads == 0 ? 1 : threads;
+    for (unsigned int i = 0; i < count; i++) {
+        workers.push_back(new Worker(*this));
+        workers.back()->Start();
+    }
+    logger.info << "Decoding " << jobs.size() << " textures on "
+                << count << " threads" << logger.end;
+}
+
+// Uploads decoded images until the byte budget of the frame is used
+void TexturePipeline::Upload() {
+    if (uploaded == jobs.size()) return;
+
+    unsigned int bytes = 0;
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    while (bytes < uploadBudget) {
+        lock.Lock();
+        Job* job = NULL;
+        if (!ready.empty()) {
+            job = ready.front();
+            ready.pop_front();
+        }
+        lock.Unlock();
+        if (job == NULL) break;
+
+        uploaded++;
+        if (!job->decoded) {
+            logger.warning << "Can not decode texture " << job->texture->GetID()
+                           << ", keeping the placeholder" << logger.end;
+            continue;
+        }
+        GLenum format = GL_RGBA;
+        if (job->image.channels == 3) format = GL_RGB;
+        else if (job->image.channels == 1) format = GL_LUMINANCE;
+
+        glBindTexture(GL_TEXTURE_2D, job->texture->GetID());
+        for (unsigned int l = 0; l < job->image.levels.size(); l++) {
+            MipLevel& level = job->image.levels[l];
+            glTexImage2D(GL_TEXTURE_2D, l, format, level.width, level.height, 0,
+                         format, GL_UNSIGNED_BYTE, &level.pixels[0]);
+            bytes += level.pixels.size();
+        }
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+        job->image.levels.clear();
+    }
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    if (uploaded == jobs.size()) {
+        Finish();
+        logger.info << "All " << jobs.size() << " textures resident after "
+                    << timer.GetElapsedTime().AsInt() / 1000 << " ms" << logger.end;
+    }
+}
+
+void TexturePipeline::Finish() {
+    for (unsigned int i = 0; i < workers.size(); i++) {
+        workers[i]->Wait();
+        delete workers[i];
+    }
+    workers.clear();
+}
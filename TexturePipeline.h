@@ -0,0 +1,137 @@
+// Threaded texture decoding with incremental upload.
+// -------------------------------------------------------------------
+// Copyright (C) 2007 OpenEngine.dk (See AUTHORS)
+//
+// This program is free software; It is covered by the GNU General
+// Public License version 2 or any later version.
+// See the GNU General Public License for more details (see LICENSE).
+//--------------------------------------------------------------------
+
+#ifndef _TEXTURE_PIPELINE_
+#define _TEXTURE_PIPELINE_
+
+#include <Core/EngineEvents.h>
+#include <Core/IListener.h>
+#include <Core/Mutex.h>
+#include <Core/Thread.h>
+#include <Renderers/IRenderer.h>
+#include <Resources/ITextureResource.h>
+#include <Scene/ISceneNode.h>
+#include <Utils/Timer.h>
+
+#include "TextureDecoder.h"
+
+#include <deque>
+#include <set>
+#include <vector>
+
+using OpenEngine::Core::DeinitializeEventArg;
+using OpenEngine::Core::IListener;
+using OpenEngine::Core::Mutex;
+using OpenEngine::Core::Thread;
+using OpenEngine::Renderers::RenderingEventArg;
+using OpenEngine::Resources::ITextureResource;
+using OpenEngine::Resources::ITextureResourcePtr;
+using OpenEngine::Scene::ISceneNode;
+using OpenEngine::Utils::Timer;
+using std::deque;
+using std::set;
+using std::vector;
+
+/**
+ * Loads the textures of the scene on worker threads while the
+ * renderer is already running.
+ *
+ * The textures are collected from the geometry of the scene when
+ * the pipeline is created, so it must be created before the scene is
+ * transformed to vertex arrays. On renderer initialize every texture
+ * gets a texture id holding a grey placeholder, so display lists and
+ * the renderer can bind it right away, and is handed to the workers.
+ * A worker decodes the texture and builds its mipmaps
+ * (TextureDecoder) and queues the result. On every renderer process
+ * the queued images are uploaded into their texture ids, up to a
+ * byte budget per frame to keep the frame time even.
+ *
+ * Must be attached to the renderer initialize event before the
+ * TextureLoader, which then skips the textures that have an id. The
+ * deinitialize listener stops the workers after their current
+ * texture and joins them, in case the engine stops before every
+ * texture is resident.
+ */
+class TexturePipeline {
+private:
+    class Initializer : public IListener<RenderingEventArg> {
+    private:
+        TexturePipeline& pipeline;
+    public:
+        Initializer(TexturePipeline& pipeline);
+        void Handle(RenderingEventArg arg);
+    };
+
+    class Uploader : public IListener<RenderingEventArg> {
+    private:
+        TexturePipeline& pipeline;
+    public:
+        Uploader(TexturePipeline& pipeline);
+        void Handle(RenderingEventArg arg);
+    };
+
+    class Stopper : public IListener<DeinitializeEventArg> {
+    private:
+        TexturePipeline& pipeline;
+    public:
+        Stopper(TexturePipeline& pipeline);
+        void Handle(DeinitializeEventArg arg);
+    };
+
+    class Worker : public Thread {
+    private:
+        TexturePipeline& pipeline;
+    public:
+        Worker(TexturePipeline& pipeline);
+        void Run();
+    };
+    friend class Initializer;
+    friend class Uploader;
+    friend class Stopper;
+    friend class Worker;
+
+    struct Job {
+        ITextureResourcePtr texture;
+        DecodedImage image;
+        bool decoded;
+    };
+
+    unsigned int threads;
+    unsigned int uploadBudget;
+    Initializer initializer;
+    Uploader uploader;
+    Stopper stopper;
+    vector<Worker*> workers;
+    vector<Job*> jobs;
+    unsigned int nextJob;
+    deque<Job*> ready;
+    Mutex lock;
+    unsigned int uploaded;
+    Timer timer;
+
+    void Collect(ISceneNode* node, set<ITextureResource*>& seen);
+    void Start();
+    void Upload();
+    void Finish();
+
+public:
+    TexturePipeline(ISceneNode* scene, unsigned int threads);
+    ~TexturePipeline();
+
+    IListener<RenderingEventArg>& InitializeListener();
+    IListener<RenderingEventArg>& ProcessListener();
+    IListener<DeinitializeEventArg>& DeinitializeListener();
+
+    void SetUploadBudget(unsigned int bytes);
+
+    unsigned int GetTextureCount() const;
+    unsigned int GetUploadedCount() const;
+};
+
+#endif
@@ -0,0 +1,61 @@
+#include "TrafficModule.h"
+
+#include <Math/Quaternion.h>
+
+#include <cmath>
+
+using OpenEngine::Math::Quaternion;
+
+TrafficModule::TrafficModule(VehicleSwarm& swarm, float timeStep)
+    : swarm(swarm)
+    , timeStep(timeStep)
+    , throttle(200.0f)
+    , frame(0)
+    , accumulator(0)
+{}
+
+void TrafficModule::SetNode(unsigned int vehicle, TransformationNode* node) {
+    if (nodes.size() <= vehicle) nodes.resize(vehicle + 1, NULL);
+    nodes[vehicle] = node;
+}
+
+void TrafficModule::Update() {
+    // Each vehicle weaves with its own phase, which is deterministic
+    // and keeps the vehicles spread out.
+    const unsigned int n = swarm.Size();
+    for (unsigned int i = 0; i < n; i++) {
+        float steer = sin(frame * timeStep + i * 0.37f);
+        swarm.Drive(i, throttle, steer, timeStep);
+    }
+    swarm.Step(timeStep);
+    frame++;
+
+    for (unsigned int i = 0; i < nodes.size() && i < n; i++) {
+        if (nodes[i] == NULL) continue;
+        float h = -swarm.heading[i] * 0.5f;
+        nodes[i]->SetPosition(Vector<3,float>(swarm.px[i], swarm.py[i], swarm.pz[i]));
+        nodes[i]->SetRotation(Quaternion<float>(cos(h), Vector<3,float>(0, sin(h), 0)));
+    }
+}
+
+void TrafficModule::Handle(InitializeEventArg arg) {
+    frame = 0;
+    accumulator = 0;
+    timer.Start();
+}
+
+void TrafficModule::Handle(ProcessEventArg arg) {
+    accumulator += timer.GetElapsedTimeAndReset().AsInt();
+    const unsigned int stepTime = (unsigned int)(timeStep * 1000000);
+    unsigned int substeps = 0;
+    while (accumulator >= stepTime && substeps < MAX_SUBSTEPS) {
+        accumulator -= stepTime;
+        Update();
+        substeps++;
+    }
+    // Over budget, keep less than a step and let the rest go
+    if (accumulator >= stepTime)
+        accumulator %= stepTime;
+}
+
+void TrafficModule::Handle(DeinitializeEventArg arg) {}
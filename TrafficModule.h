@@ -0,0 +1,59 @@
+// AI traffic driven by the vehicle swarm.
+// -------------------------------------------------------------------
+// Copyright (C) 2007 OpenEngine.dk (See AUTHORS)
+//
+// This program is free software; It is covered by the GNU General
+// Public License version 2 or any later version.
+// See the GNU General Public License for more details (see LICENSE).
+//--------------------------------------------------------------------
+
+#ifndef _TRAFFIC_MODULE_
+#define _TRAFFIC_MODULE_
+
+#include <Core/IModule.h>
+#include <Scene/TransformationNode.h>
+#include <Utils/Timer.h>
+
+#include "VehicleSwarm.h"
+
+using OpenEngine::Core::IModule;
+using OpenEngine::Core::InitializeEventArg;
+using OpenEngine::Core::ProcessEventArg;
+using OpenEngine::Core::DeinitializeEventArg;
+using OpenEngine::Scene::TransformationNode;
+using OpenEngine::Utils::Timer;
+
+/**
+ * Drives every vehicle of a swarm with a simple AI, steps the swarm
+ * with a fixed time step and moves a transformation node per vehicle
+ * to the simulated position and heading.
+ *
+ * The wall clock time of each frame is accumulated and the swarm is
+ * stepped while a whole step is left, at most MAX_SUBSTEPS times per
+ * frame, so the traffic moves at the same speed at any frame rate.
+ * Time beyond that is dropped, as in the PhysicsScheduler.
+ */
+class TrafficModule : public IModule {
+private:
+    VehicleSwarm& swarm;
+    vector<TransformationNode*> nodes;
+    float timeStep;
+    float throttle;
+    unsigned int frame;
+    unsigned int accumulator;     // usec not yet simulated
+    Timer timer;
+
+public:
+    static const unsigned int MAX_SUBSTEPS = 5;
+
+    TrafficModule(VehicleSwarm& swarm, float timeStep = 0.01f);
+
+    void SetNode(unsigned int vehicle, TransformationNode* node);
+    void Update();
+
+    void Handle(InitializeEventArg arg);
+    void Handle(ProcessEventArg arg);
+    void Handle(DeinitializeEventArg arg);
+};
+
+#endif
@@ -0,0 +1,194 @@
+#include "VehicleSwarm.h"
+
+#include <algorithm>
+#include <cmath>
+
+VehicleSwarm::VehicleSwarm()
+    : gravity(-9.82f * 20)
+    , ground(0.0f)
+    , restitution(0.2f)
+    , friction(0.98f)
+    , cellSize(20.0f)
+    , pairTests(0)
+    , contacts(0)
+{}
+
+unsigned int VehicleSwarm::Add(float x, float y, float z,
+                               float mass, float r) {
+    px.push_back(x); py.push_back(y); pz.push_back(z);
+    vx.push_back(0); vy.push_back(0); vz.push_back(0);
+    fx.push_back(0); fy.push_back(0); fz.push_back(0);
+    invMass.push_back(1.0f / mass);
+    radius.push_back(r);
+    heading.push_back(0);
+    cellSize = std::max(cellSize, 2 * r);
+    return px.size() - 1;
+}
+
+unsigned int VehicleSwarm::Size() const {
+    return px.size();
+}
+
+void VehicleSwarm::Clear() {
+    px.clear(); py.clear(); pz.clear();
+    vx.clear(); vy.clear(); vz.clear();
+    fx.clear(); fy.clear(); fz.clear();
+    invMass.clear(); radius.clear(); heading.clear();
+}
+
+void VehicleSwarm::AddForce(unsigned int body, float x, float y, float z) {
+    fx[body] += x;
+    fy[body] += y;
+    fz[body] += z;
+}
+
+void VehicleSwarm::Drive(unsigned int body, float throttle, float steer, float dt) {
+    heading[body] += steer * dt;
+    float force = throttle / invMass[body];
+    fx[body] += cos(heading[body]) * force;
+    fz[body] += sin(heading[body]) * force;
+}
+
+void VehicleSwarm::SetGravity(float g) {
+    gravity = g;
+}
+
+void VehicleSwarm::SetGroundHeight(float height) {
+    ground = height;
+}
+
+void VehicleSwarm::Step(float dt) {
+    pairTests = contacts = 0;
+    if (px.empty()) return;
+    Integrate(dt);
+    CollideGround();
+    BuildGrid();
+    CollidePairs();
+}
+
+// Semi-implicit Euler over the arrays. The loops have no aliasing
+// between arrays and no branches, so they vectorize.
+void VehicleSwarm::Integrate(float dt) {
+    const unsigned int n = px.size();
+    float* _px = &px[0]; float* _py = &py[0]; float* _pz = &pz[0];
+    float* _vx = &vx[0]; float* _vy = &vy[0]; float* _vz = &vz[0];
+    float* _fx = &fx[0]; float* _fy = &fy[0]; float* _fz = &fz[0];
+    const float* _im = &invMass[0];
+    const float g = gravity * dt;
+
+    for (unsigned int i = 0; i < n; i++) {
+        _vx[i] += _fx[i] * _im[i] * dt;
+        _vy[i] += _fy[i] * _im[i] * dt + g;
+        _vz[i] += _fz[i] * _im[i] * dt;
+    }
+    for (unsigned int i = 0; i < n; i++) {
+        _px[i] += _vx[i] * dt;
+        _py[i] += _vy[i] * dt;
+        _pz[i] += _vz[i] * dt;
+    }
+    for (unsigned int i = 0; i < n; i++)
+        _fx[i] = _fy[i] = _fz[i] = 0;
+}
+
+void VehicleSwarm::CollideGround() {
+    const unsigned int n = px.size();
+    for (unsigned int i = 0; i < n; i++) {
+        float bottom = ground + radius[i];
+        if (py[i] >= bottom) continue;
+        py[i] = bottom;
+        if (vy[i] < 0) vy[i] = -vy[i] * restitution;
+        vx[i] *= friction;
+        vz[i] *= friction;
+    }
+}
+
+unsigned int VehicleSwarm::Hash(int x, int z) const {
+    return ((unsigned int)x * 73856093u ^ (unsigned int)z * 19349663u)
+        & (cellStart.size() - 2);
+}
+
+// Counting sort of the vehicles by hashed grid cell
+void VehicleSwarm::BuildGrid() {
+    const unsigned int n = px.size();
+    unsigned int table = 1;
+    while (table < 2 * n) table <<= 1;
+    cellStart.assign(table + 1, 0);
+    cellOf.resize(n);
+    sorted.resize(n);
+
+    for (unsigned int i = 0; i < n; i++) {
+        int x = (int)floor(px[i] / cellSize);
+        int z = (int)floor(pz[i] / cellSize);
+        cellOf[i] = Hash(x, z);
+        cellStart[cellOf[i] + 1]++;
+    }
+    for (unsigned int c = 0; c < table; c++)
+        cellStart[c + 1] += cellStart[c];
+    vector<unsigned int> fill(cellStart.begin(), cellStart.end() - 1);
+    for (unsigned int i = 0; i < n; i++)
+        sorted[fill[cellOf[i]]++] = i;
+}
+
+void VehicleSwarm::CollidePairs() {
+    const unsigned int n = px.size();
+    for (unsigned int a = 0; a < n; a++) {
+        int x = (int)floor(px[a] / cellSize);
+        int z = (int)floor(pz[a] / cellSize);
+
+        // the neighbouring cells, without duplicate hash buckets
+        unsigned int cells[9];
+        unsigned int count = 0;
+        for (int dx = -1; dx <= 1; dx++)
+            for (int dz = -1; dz <= 1; dz++) {
+                unsigned int c = Hash(x + dx, z + dz);
+                if (std::find(cells, cells + count, c) == cells + count)
+                    cells[count++] = c;
+            }
+
+        for (unsigned int k = 0; k < count; k++) {
+            unsigned int c = cells[k];
+            for (unsigned int s = cellStart[c]; s < cellStart[c + 1]; s++) {
+                unsigned int b = sorted[s];
+                if (b <= a) continue;
+                pairTests++;
+                Resolve(a, b);
+            }
+        }
+    }
+}
+
+void VehicleSwarm::Resolve(unsigned int a, unsigned int b) {
+    float dx = px[b] - px[a];
+    float dy = py[b] - py[a];
+    float dz = pz[b] - pz[a];
+    float r = radius[a] + radius[b];
+    float d2 = dx*dx + dy*dy + dz*dz;
+    if (d2 >= r*r || d2 == 0) return;
+    contacts++;
+
+    float d = sqrt(d2);
+    float nx = dx / d, ny = dy / d, nz = dz / d;
+
+    // separate the spheres in proportion to their inverse masses
+    float w = invMass[a] + invMass[b];
+    float push = (r - d) / w;
+    px[a] -= nx * push * invMass[a]; px[b] += nx * push * invMass[b];
+    py[a] -= ny * push * invMass[a]; py[b] += ny * push * invMass[b];
+    pz[a] -= nz * push * invMass[a]; pz[b] += nz * push * invMass[b];
+
+    // exchange the approaching velocity along the normal
+    float vn = (vx[b]-vx[a])*nx + (vy[b]-vy[a])*ny + (vz[b]-vz[a])*nz;
+    if (vn >= 0) return;
+    float j = -(1 + restitution) * vn / w;
+    vx[a] -= nx * j * invMass[a]; vx[b] += nx * j * invMass[b];
+    vy[a] -= ny * j * invMass[a]; vy[b] += ny * j * invMass[b];
+    vz[a] -= nz * j * invMass[a]; vz[b] += nz * j * invMass[b];
+}
+
+unsigned int VehicleSwarm::GetPairTests() const {
+    return pairTests;
+}
+
+unsigned int VehicleSwarm::GetContacts() const {
+    return contacts;
+}
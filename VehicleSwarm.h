@@ -0,0 +1,85 @@
+// Structure of arrays store for many simulated vehicles.
+// -------------------------------------------------------------------
+// Copyright (C) 2007 OpenEngine.dk (See AUTHORS)
+//
+// This program is free software; It is covered by the GNU General
+// Public License version 2 or any later version.
+// See the GNU General Public License for more details (see LICENSE).
+//--------------------------------------------------------------------
+
+#ifndef _VEHICLE_SWARM_
+#define _VEHICLE_SWARM_
+
+#include <vector>
+
+using std::vector;
+
+/**
+ * Simplified rigid bodies for large numbers of vehicles.
+ *
+ * Each vehicle is a sphere with position, velocity, accumulated
+ * force, inverse mass, radius and heading. Every property is kept in
+ * its own contiguous array, so force accumulation and integration
+ * are plain loops over floats that the compiler can vectorize.
+ *
+ * Vehicles collide with a flat ground plane, at y = 0 unless moved
+ * with SetGroundHeight, and with each other. Pairs are found with a
+ * uniform grid over the ground plane: the vehicles are counting
+ * sorted into hashed grid cells and each one is only tested against
+ * the vehicles in its own and the eight neighbouring cells, instead
+ * of against all others.
+ *
+ * Collision with the track geometry is not part of the store, so the
+ * swarm drives on the plane wherever the track lies; the RigidBox of
+ * the player vehicle still handles that.
+ */
+class VehicleSwarm {
+public:
+    vector<float> px, py, pz;       // position
+    vector<float> vx, vy, vz;       // velocity
+    vector<float> fx, fy, fz;       // accumulated force
+    vector<float> invMass;
+    vector<float> radius;
+    vector<float> heading;          // rotation about the y axis
+
+private:
+    float gravity;
+    float ground;
+    float restitution;
+    float friction;
+    float cellSize;
+    unsigned int pairTests, contacts;
+
+    // broadphase grid
+    vector<unsigned int> cellOf;
+    vector<unsigned int> cellStart;
+    vector<unsigned int> sorted;
+
+    unsigned int Hash(int x, int z) const;
+    void Integrate(float dt);
+    void CollideGround();
+    void BuildGrid();
+    void CollidePairs();
+    void Resolve(unsigned int a, unsigned int b);
+
+public:
+    VehicleSwarm();
+
+    unsigned int Add(float x, float y, float z,
+                     float mass = 1.0f, float radius = 10.0f);
+    unsigned int Size() const;
+    void Clear();
+
+    void AddForce(unsigned int body, float x, float y, float z);
+    void Drive(unsigned int body, float throttle, float steer, float dt);
+
+    void SetGravity(float g);
+    void SetGroundHeight(float height);
+
+    void Step(float dt);
+
+    unsigned int GetPairTests() const;
+    unsigned int GetContacts() const;
+};
+
+#endif
@@ -14,8 +14,13 @@
 #include <fstream>
 #include <Utils/Serialization.h>
 
+#include <cmath>
+#include <cstdio>
+#include <sstream>
+
 // Core structures
 #include <Core/Engine.h>
+#include <Math/Math.h>
 
 // Display structures
 #include <Display/FollowCamera.h>
@@ -45,6 +50,7 @@
 // Scene structures
 #include <Scene/SceneNode.h>
 #include <Scene/GeometryNode.h>
+#include <Geometry/FaceSet.h>
 #include <Scene/TransformationNode.h>
 #include <Scene/VertexArrayTransformer.h>
 #include <Scene/DisplayListTransformer.h>
@@ -52,7 +58,6 @@
 // AccelerationStructures extension
 #include <Scene/CollectedGeometryTransformer.h>
 #include <Scene/QuadTransformer.h>
-#include <Scene/BSPTransformer.h>
 #include <Scene/ASDotVisitor.h>
 #include <Renderers/AcceleratedRenderingView.h>
 
@@ -70,11 +75,40 @@
 // LayerNode
 #include <Scene/LayerNode.h>
 #include <Display/TextSurface.h>
-#include <Utils/LayerStatistics.h>
 
 
 // OERacer utility files
 #include "KeyboardHandler.h"
+#include "HeadlessRunner.h"
+#include "ModelLoader.h"
+#include "QuadTuner.h"
+#include "SceneArena.h"
+#include "SceneBounds.h"
+#include "CollisionTree.h"
+#include "ContentKey.h"
+#include "LODSelector.h"
+#include "QualityGovernor.h"
+#include "PhysicsCache.h"
+#include "ScenePackage.h"
+#include "StaticBatcher.h"
+#include "ModuleProfiler.h"
+#include "StartupProfiler.h"
+#include "HUDPanel.h"
+#include "HUDStatistics.h"
+#include "HUDTextureUploader.h"
+#include "TexturePipeline.h"
+#include "InputRecorder.h"
+#include "InputReplay.h"
+#include "PhysicsThread.h"
+#include "PhysicsTreeBuilder.h"
+#include "PhysicsSnapshots.h"
+#include "InputQueue.h"
+#include "PhysicsScheduler.h"
+#include "TaskScheduler.h"
+#include "AsyncLogger.h"
+#include "PoseInterpolator.h"
+#include "VehicleSwarm.h"
+#include "TrafficModule.h"
 
 // Additional namespaces
 using namespace OpenEngine::Core;
@@ -105,6 +139,39 @@ struct Config {
     RigidBox*             physicBody;
     FixedTimeStepPhysics* physics;
     bool                  resourcesLoaded;
+    bool                  headless;
+    unsigned int          headlessTicks;
+    unsigned int          loadThreads;
+    string                cacheDirectory;
+    vector<string>        physicFiles;
+    PhysicsTreeSettings   physicsSettings;
+    unsigned int          treeThreads;
+    unsigned int          staticQuadFaces;
+    unsigned int          staticQuadSize;
+    ScenePackage*         scenePackage;
+    bool                  bakeScene;
+    unsigned int          textureThreads;
+    bool                  levelOfDetail;
+    LODSelector*          lod;
+    unsigned int          targetFrameTime;
+    unsigned int          sceneArena;     // mb, 0 for none
+    bool                  batchStatic;
+    ModuleProfiler*       profiler;
+    StartupProfiler*      startup;
+    TaskScheduler*        tasks;
+    HUDPanel*             hud;
+    string                recordFile;
+    string                replayFile;
+    unsigned int          physicsRate;
+    PhysicsCommandQueue*  physicsCommands;
+    PhysicsThread*        physicsThread;
+    PhysicsSnapshots*     physicsSnapshots;
+    unsigned int          physicsStepRate;
+    unsigned int          physicsSubsteps;
+    PhysicsScheduler*     physicsScheduler;
+    TransformationNode*   vehicleNode;
+    ISceneNode*           vehicleModel;
+    unsigned int          trafficVehicles;
     Config(IEngine& engine)
         : engine(engine)
         , frame(NULL)
@@ -121,6 +188,35 @@ struct Config {
         , physicScene(NULL)
         , physics(NULL)
         , resourcesLoaded(false)
+        , headless(false)
+        , headlessTicks(0)
+        , loadThreads(0)
+        , cacheDirectory("projects/OERacerHUD/")
+        , treeThreads(0)
+        , staticQuadFaces(500)
+        , staticQuadSize(100)
+        , scenePackage(NULL)
+        , bakeScene(false)
+        , textureThreads(0)
+        , levelOfDetail(false)
+        , lod(NULL)
+        , targetFrameTime(0)
+        , sceneArena(0)
+        , batchStatic(false)
+        , profiler(NULL)
+        , startup(NULL)
+        , tasks(NULL)
+        , hud(NULL)
+        , physicsRate(0)
+        , physicsCommands(NULL)
+        , physicsThread(NULL)
+        , physicsSnapshots(NULL)
+        , physicsStepRate(100)
+        , physicsSubsteps(5)
+        , physicsScheduler(NULL)
+        , vehicleNode(NULL)
+        , vehicleModel(NULL)
+        , trafficVehicles(0)
     {}
 };
 
@@ -131,11 +227,55 @@ void SetupScene(Config&);
 void SetupPhysics(Config&);
 void SetupRendering(Config&);
 void SetupDevices(Config&);
+void SetupTraffic(Config&);
 void SetupDebugging(Config&);
+void BenchmarkLoading(Config&, unsigned int threads);
+void BenchmarkHUD(unsigned int updates);
+void BenchmarkLogging(string directory, unsigned int messages);
+void BenchmarkVehicles(unsigned int maxVehicles);
+void TuneQuads(Config&);
+void BenchmarkCulling(Config&, unsigned int runs);
+void BenchmarkCollision(Config&, unsigned int runs);
+void BenchmarkPhysicsTree(Config&, unsigned int threads);
+
+// Run a setup method as a phase of the startup profiler
+void RunSetup(Config& config, void (*setup)(Config&), string name) {
+    config.startup->Begin(name);
+    setup(config);
+    config.startup->End();
+}
+
+// Attach a module to the engine process event, through the module
+// profiler if profiling is enabled. With the task scheduler the
+// module becomes a task using the given resources instead.
+void AttachProcess(Config& config,
+                   IListener<ProcessEventArg>& listener,
+                   string name,
+                   unsigned int reads = TaskScheduler::ALL,
+                   unsigned int writes = TaskScheduler::ALL) {
+    if (config.tasks != NULL)
+        config.tasks->Add(listener, name, reads, writes);
+    else if (config.profiler != NULL)
+        config.profiler->Attach(config.engine.ProcessEvent(), listener, name);
+    else
+        config.engine.ProcessEvent().Attach(listener);
+}
+
+// The console logger, written out and removed when main returns
+AsyncLogger* consoleLogger = NULL;
+
+void StopLogging() {
+    Logger::RemoveLogger(consoleLogger);
+    delete consoleLogger;
+    consoleLogger = NULL;
+}
 
 int main(int argc, char** argv) {
-    // Setup logging facilities.
-    Logger::AddLogger(new StreamLogger(&std::cout));
+    // Setup logging facilities. Messages are written to the console
+    // from a background thread.
+    consoleLogger = new AsyncLogger(&std::cout);
+    Logger::AddLogger(consoleLogger);
+    atexit(StopLogging);
 
     // Print usage info.
     logger.info << "========= Running The OpenEngine Racer Project =========" << logger.end;
@@ -147,6 +287,8 @@ int main(int argc, char** argv) {
     logger.info << "  drive backwards: down-arrow" << logger.end;
     logger.info << "  turn left:       left-arrow" << logger.end;
     logger.info << "  turn right:      right-arrow" << logger.end;
+    logger.info << "  reset:           r" << logger.end;
+    logger.info << "  rewind:          backspace (100 physics steps)" << logger.end;
     logger.info << logger.end;
     logger.info << "Camera controls:" << logger.end;
     logger.info << "  move forwards:   w" << logger.end;
@@ -159,18 +301,223 @@ int main(int argc, char** argv) {
     // Create an engine and config object
     Engine* engine = new Engine();
     Config config(*engine);
+    config.startup = new StartupProfiler();
+
+    // Parse command line options.
+    //   --headless [ticks]     run the simulation without frame and renderer
+    //   --load-threads n       load the models on n worker threads
+    //   --bench-loading n      compare serial and n-threaded loading and exit
+    //   --cache-dir path       directory of the physics tree cache
+    //   --profile [file]       profile the modules, trace to .json or .csv
+    //   --bench-hud n          time n HUD panel updates and exit
+    //   --bench-logging n      compare n log calls through both loggers
+    //   --record file          record the vehicle input to file
+    //   --replay file          drive the vehicle from a recorded input log
+    //   --physics-thread hz    step the physics on its own thread
+    //   --physics-rate hz      fixed physics step rate on the engine thread
+    //   --max-substeps n       physics steps per frame before time dilates
+    //   --vehicles n           add n AI driven vehicles
+    //   --bench-vehicles [n]   time the vehicle physics for 1 to n bodies
+    //   --tune-quads           sweep the quad tree settings and exit
+    //   --bake                 write the static scene package and exit
+    //   --texture-threads n    decode the textures on n worker threads
+    //   --bench-culling [runs] compare per node and batched frustum culling
+    //   --bench-collision [runs] compare the collision tree and the quad tree
+    //   --startup-report file  write the startup phase times as JSON
+    //   --lod                  distance based detail levels for the static scene
+    //   --batch-static         merge the static quad cells by material
+    //   --target-frame ms      lower the quality to hold a frame time
+    //   --tasks n              run independent modules on n worker threads
+    //   --tree-threads n       build the physics BSP trees on n worker threads
+    //   --scene-arena mb       build the scene and physics trees in an arena
+    //   --bench-physics-tree n build the physics tree on 1 to n threads
+    unsigned int benchLoading = 0;
+    bool tuneQuads = false;
+    unsigned int benchCulling = 0;
+    unsigned int benchCollision = 0;
+    unsigned int benchPhysicsTree = 0;
+    unsigned int taskThreads = 0;
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        if (arg == "--headless") {
+            config.headless = true;
+            if (i+1 < argc && argv[i+1][0] != '-')
+                config.headlessTicks = atoi(argv[++i]);
+        }
+        else if (arg == "--load-threads" && i+1 < argc)
+            config.loadThreads = atoi(argv[++i]);
+        else if (arg == "--bench-loading" && i+1 < argc)
+            benchLoading = atoi(argv[++i]);
+        else if (arg == "--profile") {
+            config.profiler = new ModuleProfiler();
+            config.engine.DeinitializeEvent().Attach(*config.profiler);
+            if (i+1 < argc && argv[i+1][0] != '-')
+                config.profiler->SetTraceFile(argv[++i]);
+        }
+        else if (arg == "--bench-hud" && i+1 < argc) {
+            BenchmarkHUD(atoi(argv[++i]));
+            return EXIT_SUCCESS;
+        }
+        else if (arg == "--bench-logging" && i+1 < argc) {
+            BenchmarkLogging(config.cacheDirectory, atoi(argv[++i]));
+            return EXIT_SUCCESS;
+        }
+        else if (arg == "--record" && i+1 < argc)
+            config.recordFile = argv[++i];
+        else if (arg == "--replay" && i+1 < argc)
+            config.replayFile = argv[++i];
+        else if (arg == "--physics-thread" && i+1 < argc) {
+            config.physicsRate = atoi(argv[++i]);
+            if (config.physicsRate == 0)
+                logger.warning << "Invalid physics thread rate: " << argv[i]
+                               << logger.end;
+        }
+        else if (arg == "--physics-rate" && i+1 < argc) {
+            unsigned int rate = atoi(argv[++i]);
+            if (rate != 0)
+                config.physicsStepRate = rate;
+            else
+                logger.warning << "Invalid physics rate: " << argv[i]
+                               << logger.end;
+        }
+        else if (arg == "--max-substeps" && i+1 < argc) {
+            unsigned int substeps = atoi(argv[++i]);
+            if (substeps != 0)
+                config.physicsSubsteps = substeps;
+            else
+                logger.warning << "Invalid physics substeps: " << argv[i]
+                               << logger.end;
+        }
+        else if (arg == "--vehicles" && i+1 < argc)
+            config.trafficVehicles = atoi(argv[++i]);
+        else if (arg == "--bench-vehicles") {
+            unsigned int n = 1000;
+            if (i+1 < argc && argv[i+1][0] != '-')
+                n = atoi(argv[++i]);
+            BenchmarkVehicles(n);
+            return EXIT_SUCCESS;
+        }
+        else if (arg == "--tune-quads")
+            tuneQuads = true;
+        else if (arg == "--bake")
+            config.bakeScene = true;
+        else if (arg == "--texture-threads" && i+1 < argc)
+            config.textureThreads = atoi(argv[++i]);
+        else if (arg == "--lod")
+            config.levelOfDetail = true;
+        else if (arg == "--batch-static")
+            config.batchStatic = true;
+        else if (arg == "--scene-arena" && i+1 < argc)
+            config.sceneArena = atoi(argv[++i]);
+        else if (arg == "--tree-threads" && i+1 < argc)
+            config.treeThreads = atoi(argv[++i]);
+        else if (arg == "--bench-physics-tree" && i+1 < argc)
+            benchPhysicsTree = atoi(argv[++i]);
+        else if (arg == "--tasks" && i+1 < argc)
+            taskThreads = atoi(argv[++i]);
+        else if (arg == "--target-frame" && i+1 < argc)
+            config.targetFrameTime = (unsigned int)(atof(argv[++i]) * 1000);
+        else if (arg == "--startup-report" && i+1 < argc)
+            config.startup->SetReportFile(argv[++i]);
+        else if (arg == "--bench-culling") {
+            benchCulling = 100;
+            if (i+1 < argc && argv[i+1][0] != '-')
+                benchCulling = atoi(argv[++i]);
+        }
+        else if (arg == "--bench-collision") {
+            benchCollision = 100;
+            if (i+1 < argc && argv[i+1][0] != '-')
+                benchCollision = atoi(argv[++i]);
+        }
+        else if (arg == "--cache-dir" && i+1 < argc)
+            config.cacheDirectory = string(argv[++i]) + "/";
+        else
+            logger.warning << "Unknown option: " << arg << logger.end;
+    }
+
+    // Headless runs step the physics once per tick already
+    if (config.headless && config.physicsRate != 0) {
+        logger.warning << "Ignoring --physics-thread in headless mode" << logger.end;
+        config.physicsRate = 0;
+    }
+
+    // Every module attached from here on runs as a task within the
+    // single scheduler listener
+    if (taskThreads != 0) {
+        config.tasks = new TaskScheduler(taskThreads);
+        config.engine.InitializeEvent().Attach(*config.tasks);
+        if (config.profiler != NULL)
+            config.profiler->Attach(config.engine.ProcessEvent(),
+                                    *config.tasks, "TaskScheduler");
+        else
+            config.engine.ProcessEvent().Attach(*config.tasks);
+        config.engine.DeinitializeEvent().Attach(*config.tasks);
+    }
 
     // Setup the engine
-    SetupResources(config);
-    SetupDisplay(config);
-    SetupScene(config);
-    SetupPhysics(config);
-    SetupRendering(config);
-    SetupDevices(config);
+    RunSetup(config, SetupResources, "SetupResources");
+    if (benchLoading != 0) {
+        BenchmarkLoading(config, benchLoading);
+        delete engine;
+        return EXIT_SUCCESS;
+    }
+    if (tuneQuads) {
+        TuneQuads(config);
+        delete engine;
+        return EXIT_SUCCESS;
+    }
+    if (benchCulling != 0) {
+        BenchmarkCulling(config, benchCulling);
+        delete engine;
+        return EXIT_SUCCESS;
+    }
+    if (benchCollision != 0) {
+        BenchmarkCollision(config, benchCollision);
+        delete engine;
+        return EXIT_SUCCESS;
+    }
+    if (benchPhysicsTree != 0) {
+        BenchmarkPhysicsTree(config, benchPhysicsTree);
+        delete engine;
+        return EXIT_SUCCESS;
+    }
+    RunSetup(config, SetupDisplay, "SetupDisplay");
+    // The scene and physics trees live until the engine stops, so
+    // the arena holding them is never released
+    if (config.sceneArena != 0 &&
+        !SceneArena::Reserve((unsigned long)config.sceneArena << 20))
+        logger.warning << "Can not reserve a scene arena of "
+                       << config.sceneArena << " mb" << logger.end;
+    SceneArena::Begin();
+    RunSetup(config, SetupScene, "SetupScene");
+    SceneArena::End();
+    if (config.bakeScene) {
+        bool baked = config.scenePackage->Bake(*config.staticScene);
+        delete engine;
+        return baked ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+    SceneArena::Begin();
+    RunSetup(config, SetupPhysics, "SetupPhysics");
+    SceneArena::End();
+    if (SceneArena::GetCapacity() != 0)
+        logger.info << "Scene arena: " << SceneArena::GetUsed() / 1024
+                    << " of " << SceneArena::GetCapacity() / 1024 << " kb used by "
+                    << SceneArena::GetAllocationCount() << " allocations, "
+                    << SceneArena::GetFreeCount() << " freed inside, "
+                    << SceneArena::GetOverflowCount() << " did not fit"
+                    << logger.end;
+    RunSetup(config, SetupTraffic, "SetupTraffic");
+    if (!config.headless)
+        RunSetup(config, SetupRendering, "SetupRendering");
+    RunSetup(config, SetupDevices, "SetupDevices");
     
     // Possibly add some debugging stuff
     // SetupDebugging(config);
 
+    // The startup profiler reports when the engine is initialized
+    config.engine.InitializeEvent().Attach(*config.startup);
+    config.startup->Begin("Initialize");
+
     // Start up the engine.
     engine->Start();
 
@@ -200,15 +547,28 @@ void SetupDisplay(Config& config) {
         config.viewport      != NULL)
         throw Exception("Setup display dependencies are not satisfied.");
 
-    config.frame         = new SDLFrame(800, 600, 32);
     config.viewingvolume = new InterpolatedViewingVolume(*(new ViewingVolume()));
     config.camera        = new FollowCamera( *config.viewingvolume );
     config.frustum       = new Frustum(*config.camera, 20, 3000);
+
+    // Without a display the engine is driven by the headless runner
+    if (config.headless) {
+        HeadlessRunner* runner = new HeadlessRunner(config.engine,
+                                                    config.headlessTicks);
+        config.engine.InitializeEvent().Attach(*runner);
+        AttachProcess(config, *runner, "HeadlessRunner",
+                      0, TaskScheduler::LOG);
+        config.engine.DeinitializeEvent().Attach(*runner);
+        return;
+    }
+
+    config.frame         = new SDLFrame(800, 600, 32);
     config.viewport      = new Viewport(*config.frame);
     config.viewport->SetViewingVolume(config.frustum);
 
     config.engine.InitializeEvent().Attach(*config.frame);
-    config.engine.ProcessEvent().Attach(*config.frame);
+    AttachProcess(config, *config.frame, "SDLFrame",
+                  0, TaskScheduler::DISPLAY);
     config.engine.DeinitializeEvent().Attach(*config.frame);
 }
 
@@ -233,6 +593,17 @@ void SetupRendering(Config& config) {
     // Create a renderer
     config.renderer = new Renderer();
 
+    // Decode the scene textures in the background and upload them
+    // ahead of the rendering view as they become ready
+    if (config.textureThreads != 0) {
+        TexturePipeline* tp =
+            new TexturePipeline(config.renderingScene, config.textureThreads);
+        config.startup->Attach(config.renderer->InitializeEvent(),
+                               tp->InitializeListener(), "TexturePipeline");
+        config.renderer->ProcessEvent().Attach(tp->ProcessListener());
+        config.engine.DeinitializeEvent().Attach(tp->DeinitializeListener());
+    }
+
     // Setup a rendering view
     MyRenderingView* rv = new MyRenderingView(*config.viewport);
     config.renderer->ProcessEvent().Attach(*rv);
@@ -240,18 +611,31 @@ void SetupRendering(Config& config) {
     // Add rendering initialization tasks
     TextureLoader* tl = new TextureLoader();
     DisplayListTransformer* dlt = new DisplayListTransformer(rv);
-    config.renderer->InitializeEvent().Attach(*tl);
-    config.renderer->InitializeEvent().Attach(*dlt);
+    config.startup->Attach(config.renderer->InitializeEvent(), *tl, "TextureLoader");
+    config.startup->Attach(config.renderer->InitializeEvent(), *dlt,
+                           "DisplayListTransformer");
 
     // Transform the scene to use vertex arrays
     VertexArrayTransformer vaT;
+    config.startup->Begin("VertexArrayTransformer", "transformer");
     vaT.Transform(*config.renderingScene);
+    if (config.lod != NULL) {
+        // levels not in the scene right now
+        vector<ISceneNode*> levels = config.lod->GetDetachedLevels();
+        for (unsigned int i = 0; i < levels.size(); i++)
+            vaT.Transform(*levels[i]);
+    }
+    config.startup->End();
 
     // Supply the scene to the renderer
     config.renderer->SetSceneRoot(config.renderingScene);
 
-    config.engine.InitializeEvent().Attach(*config.renderer);
-    config.engine.ProcessEvent().Attach(*config.renderer);
+    config.startup->Attach(config.engine.InitializeEvent(),
+                           *config.renderer, "Renderer");
+    AttachProcess(config, *config.renderer, "Renderer",
+                  TaskScheduler::CAMERA | TaskScheduler::VEHICLE |
+                  TaskScheduler::TRAFFIC | TaskScheduler::SCENE |
+                  TaskScheduler::HUD, TaskScheduler::DISPLAY);
     config.engine.DeinitializeEvent().Attach(*config.renderer);
 }
 
@@ -263,10 +647,63 @@ void SetupDevices(Config& config) {
         config.physicBody == NULL)
         throw Exception("Setup keyboard dependencies are not satisfied.");
 
+    // Keyboard bindings to the rigid box and camera
+    KeyboardHandler* keyHandler = new KeyboardHandler(config.engine,
+                                                      config.camera,
+                                                      config.physicBody,
+                                                      config.physics);
+    // Headless ticks are not paced by the wall clock, so the input
+    // is applied as if each tick lasted 10 ms.
+    if (config.headless)
+        keyHandler->SetFixedDelta(0.1f);
+    if (config.physicsCommands != NULL)
+        keyHandler->SetCommandQueue(config.physicsCommands);
+    if (config.physicsScheduler != NULL)
+        keyHandler->SetScheduler(config.physicsScheduler);
+    keyHandler->SetSnapshots(config.physicsSnapshots);
+
+    // Vehicle input is replayed from a log instead of the devices
+    InputReplay* replay = NULL;
+    if (!config.replayFile.empty()) {
+        replay = new InputReplay(config.engine, config.replayFile);
+        config.engine.InitializeEvent().Attach(*replay);
+        AttachProcess(config, *replay, "InputReplay", TaskScheduler::CAMERA,
+                      TaskScheduler::INPUT | TaskScheduler::VEHICLE |
+                      TaskScheduler::LOG);
+        config.engine.DeinitializeEvent().Attach(*replay);
+        replay->KeyEvent().Attach(*keyHandler);
+        replay->JoystickButtonEvent().Attach(*keyHandler);
+        replay->JoystickAxisEvent().Attach(*keyHandler);
+    }
+
+    // No input devices without a display
+    if (config.headless) {
+        config.engine.InitializeEvent().Attach(*keyHandler);
+        AttachProcess(config, *keyHandler, "KeyboardHandler",
+                      TaskScheduler::INPUT | TaskScheduler::CAMERA,
+                      TaskScheduler::VEHICLE | TaskScheduler::LOG);
+        config.engine.DeinitializeEvent().Attach(*keyHandler);
+        return;
+    }
+
+    // Record the device input. The recorder counts the frames and
+    // must see the process event before the input module.
+    InputRecorder* recorder = NULL;
+    if (!config.recordFile.empty()) {
+        recorder = new InputRecorder(config.recordFile);
+        config.engine.InitializeEvent().Attach(*recorder);
+        AttachProcess(config, *recorder, "InputRecorder",
+                      0, TaskScheduler::INPUT);
+        config.engine.DeinitializeEvent().Attach(*recorder);
+    }
+
     // Create the mouse and keyboard input modules
     SDLInput* input = new SDLInput();
     config.engine.InitializeEvent().Attach(*input);
-    config.engine.ProcessEvent().Attach(*input);
+    AttachProcess(config, *input, "SDLInput", 0,
+                  TaskScheduler::INPUT | TaskScheduler::CAMERA |
+                  TaskScheduler::VEHICLE | TaskScheduler::LOG |
+                  TaskScheduler::DISPLAY);
     config.engine.DeinitializeEvent().Attach(*input);
     config.keyboard = input;
     config.mouse    = input;
@@ -282,23 +719,44 @@ void SetupDevices(Config& config) {
 
     config.joystick->JoystickAxisEvent().Attach(*move_h);
 
-    // Keyboard bindings to the rigid box and camera
-    KeyboardHandler* keyHandler = new KeyboardHandler(config.engine,
-                                                      config.camera,
-                                                      config.physicBody,
-                                                      config.physics);
-    config.keyboard->KeyEvent().Attach(*keyHandler);
-
-    config.joystick->JoystickButtonEvent().Attach(*keyHandler);
-    config.joystick->JoystickAxisEvent().Attach(*keyHandler);
+    if (replay == NULL) {
+        config.keyboard->KeyEvent().Attach(*keyHandler);
+        config.joystick->JoystickButtonEvent().Attach(*keyHandler);
+        config.joystick->JoystickAxisEvent().Attach(*keyHandler);
+    }
+    if (recorder != NULL) {
+        config.keyboard->KeyEvent().Attach(*recorder);
+        config.joystick->JoystickButtonEvent().Attach(*recorder);
+        config.joystick->JoystickAxisEvent().Attach(*recorder);
+    }
 
+    // The driving controls go to the physics steps through a time
+    // stamped queue instead of once per frame
+    InputQueue* inputQueue = new InputQueue();
+    if (replay != NULL) {
+        replay->KeyEvent().Attach(*inputQueue);
+        replay->JoystickAxisEvent().Attach(*inputQueue);
+    } else {
+        config.keyboard->KeyEvent().Attach(*inputQueue);
+        config.joystick->JoystickAxisEvent().Attach(*inputQueue);
+    }
+    config.engine.DeinitializeEvent().Attach(*inputQueue);
+    keyHandler->SetInputQueue(inputQueue);
+    if (config.physicsThread != NULL)
+        config.physicsThread->SetInputQueue(inputQueue);
+    if (config.physicsScheduler != NULL)
+        config.physicsScheduler->SetInputQueue(inputQueue, config.physicBody);
 
     config.engine.InitializeEvent().Attach(*keyHandler);
-    config.engine.ProcessEvent().Attach(*keyHandler);
+    AttachProcess(config, *keyHandler, "KeyboardHandler",
+                  TaskScheduler::INPUT | TaskScheduler::CAMERA,
+                  TaskScheduler::VEHICLE | TaskScheduler::LOG);
     config.engine.DeinitializeEvent().Attach(*keyHandler);
 
     config.engine.InitializeEvent().Attach(*move_h);
-    config.engine.ProcessEvent().Attach(*move_h);
+    AttachProcess(config, *move_h, "MoveHandler",
+                  TaskScheduler::INPUT | TaskScheduler::VEHICLE,
+                  TaskScheduler::CAMERA);
     config.engine.DeinitializeEvent().Attach(*move_h);
 }
 
@@ -307,44 +765,134 @@ void SetupPhysics(Config& config) {
         config.physicScene == NULL)
         throw Exception("Physics dependencies are not satisfied.");
 
-    ifstream isf("oeracer-physics-scene.bin", ios::binary);
-    if (isf.is_open()) {
-        logger.info << "Loading the physics tree from file: started" << logger.end;
+    // The cache is keyed by the physic models and the tree settings
+    PhysicsCache cache(config.cacheDirectory);
+    for (unsigned int i = 0; i < config.physicFiles.size(); i++)
+        cache.AddSource(config.physicFiles[i]);
+    cache.AddSettings(config.physicsSettings);
+
+    SceneNode* cached = new SceneNode();
+    config.startup->Begin("PhysicsCache", "load");
+    bool loaded = cache.Load(*cached);
+    config.startup->End();
+    if (loaded) {
         delete config.physicScene;
-        config.physicScene = new SceneNode();
-        Serialization::Deserialize(*config.physicScene, &isf);
-        isf.close();
+        config.physicScene = cached;
         logger.info << "Loading the physics tree from file: done" << logger.end;
     } else {
-        isf.close();
+        delete cached;
         logger.info << "Creating and serializing the physics tree: started" << logger.end;
         // transform the object tree to a hybrid Quad/BSP
-        CollectedGeometryTransformer collT;
-        QuadTransformer quadT;
-        BSPTransformer bspT;
-        collT.Transform(*config.physicScene);
-        quadT.Transform(*config.physicScene);
-        bspT.Transform(*config.physicScene);
+        PhysicsTreeBuilder builder(config.physicsSettings, config.treeThreads);
+        builder.Build(*config.physicScene);
+        config.startup->Add("CollectedGeometryTransformer", "transformer",
+                            builder.GetCollectTime());
+        config.startup->Add("QuadTransformer", "transformer",
+                            builder.GetQuadTime());
+        config.startup->Add("BSPTransformer", "transformer",
+                            builder.GetBSPTime());
+        if (config.treeThreads != 0)
+            logger.info << "Built " << builder.GetJobCount()
+                        << " BSP trees on " << config.treeThreads
+                        << " threads in " << builder.GetBSPTime() / 1000
+                        << " ms" << logger.end;
         // serialize the scene
-        const ISceneNode& tmp = *config.physicScene;
-        ofstream of("oeracer-physics-scene.bin");
-        Serialization::Serialize(tmp, &of);
-        of.close();
+        cache.Save(*config.physicScene);
         logger.info << "Creating and serializing the physics tree: done" << logger.end;
     }
+
+    // Face data held by the rendering and physics scenes, counting
+    // shared faces once
+    ISceneNode* scenes[2] = { config.renderingScene, config.physicScene };
+    unsigned long referenced;
+    unsigned long unique = GeometryCache::GetFaceBytes(scenes, 2, &referenced);
+    logger.info << "Scene face data: " << unique / 1024 << " kb, "
+                << (referenced - unique) / 1024 << " kb saved by sharing"
+                << logger.end;
     
     config.physics = new FixedTimeStepPhysics(config.physicScene);
 
     // Add physic bodies
     config.physics->AddRigidBody(config.physicBody);
 
-    // Add to engine for processing time (with its timer)
-    FixedTimeStepPhysicsTimer* ptimer = new FixedTimeStepPhysicsTimer(*config.physics);
+    // Snapshots of the bodies after every step, for rewinding and
+    // resetting without re-initializing the physics
+    config.physicsSnapshots = new PhysicsSnapshots();
+    config.physicsSnapshots->Add(config.physicBody);
+    config.physicsSnapshots->SetInitial();
+
+    // Step the physics on its own thread. The vehicle node is moved
+    // on the render thread from the published poses.
+    if (config.physicsRate != 0) {
+        config.physicsCommands = new PhysicsCommandQueue();
+        PhysicsThread* pthread = new PhysicsThread(*config.physics,
+                                                   config.physicBody,
+                                                   *config.physicsCommands,
+                                                   config.physicsRate);
+        config.physicsThread = pthread;
+        pthread->SetSnapshots(config.physicsSnapshots);
+        PoseInterpolator* interp = new PoseInterpolator(*pthread, config.vehicleNode);
+        config.engine.InitializeEvent().Attach(*pthread);
+        config.engine.DeinitializeEvent().Attach(*pthread);
+        AttachProcess(config, *interp, "PoseInterpolator",
+                      0, TaskScheduler::VEHICLE);
+        AttachProcess(config, *pthread, "PhysicsThread",
+                      0, TaskScheduler::LOG);
+        return;
+    }
+
+    // Add to engine for processing time (with its scheduler).
+    // Headless runs take exactly one fixed physics step per engine
+    // tick, so the simulated rate does not depend on the wall clock.
     config.engine.InitializeEvent().Attach(*config.physics);
-    config.engine.ProcessEvent().Attach(*ptimer);
+    if (config.headless) {
+        AttachProcess(config, *config.physics, "FixedTimeStepPhysics",
+                      0, TaskScheduler::VEHICLE);
+        AttachProcess(config, *config.physicsSnapshots, "PhysicsSnapshots",
+                      0, TaskScheduler::VEHICLE);
+    } else {
+        config.physicsScheduler = new PhysicsScheduler(*config.physics,
+                                                       config.physicsStepRate,
+                                                       config.physicsSubsteps);
+        config.physicsScheduler->SetSnapshots(config.physicsSnapshots);
+        config.engine.InitializeEvent().Attach(*config.physicsScheduler);
+        AttachProcess(config, *config.physicsScheduler, "PhysicsScheduler",
+                      0, TaskScheduler::VEHICLE);
+        config.engine.DeinitializeEvent().Attach(*config.physicsScheduler);
+    }
     config.engine.DeinitializeEvent().Attach(*config.physics);
 }
 
+void SetupTraffic(Config& config) {
+    if (config.trafficVehicles == 0) return;
+    if (config.dynamicScene == NULL ||
+        config.vehicleModel == NULL)
+        throw Exception("Setup traffic dependencies are not satisfied.");
+
+    // Line the vehicles up on a grid around the start position. Each
+    // has its own copy of the player vehicle nodes, as a node has only
+    // one parent, and the copies share its faces.
+    GeometryCache geometry;
+    VehicleSwarm* swarm = new VehicleSwarm();
+    TrafficModule* traffic = new TrafficModule(*swarm);
+    unsigned int side = (unsigned int)ceil(sqrt((float)config.trafficVehicles));
+    for (unsigned int i = 0; i < config.trafficVehicles; i++) {
+        unsigned int v = swarm->Add(50.0f + (i % side) * 40.0f, 20.0f,
+                                    (i / side) * 40.0f - side * 20.0f);
+        TransformationNode* node = new TransformationNode();
+        node->AddNode(geometry.Share(config.vehicleModel));
+        config.dynamicScene->AddNode(node);
+        traffic->SetNode(v, node);
+    }
+    config.engine.InitializeEvent().Attach(*traffic);
+    AttachProcess(config, *traffic, "TrafficModule",
+                  0, TaskScheduler::TRAFFIC);
+    config.engine.DeinitializeEvent().Attach(*traffic);
+    logger.info << "Added " << config.trafficVehicles << " AI vehicles, "
+                << geometry.GetSavedBytes() / 1024 << " kb of faces shared"
+                << logger.end;
+}
+
 void SetupScene(Config& config) {
     if (config.dynamicScene    != NULL ||
         config.staticScene     != NULL ||
@@ -362,46 +910,84 @@ void SetupScene(Config& config) {
     config.renderingScene->AddNode(config.dynamicScene);
     config.renderingScene->AddNode(config.staticScene);
 
-    ISceneNode* current = config.dynamicScene;
+    ISceneNode* current = NULL;
 
     // Position of the vehicle
     Vector<3,float> position(2, 100, 2);
 
-    // Add models from models.txt to the scene
-    ifstream* mfile = File::Open("projects/OERacerHUD/models.txt");
-    
-    bool dynamic = false;
-    while (!mfile->eof()) {
-        string mod_str;
-        getline(*mfile, mod_str);
-
-        // Check the string
-        if (mod_str[0] == '#' || mod_str == "") continue;
+    // Read models.txt and load all the listed models
+    ModelLoader loader(config.loadThreads);
+    loader.ReadManifest("projects/OERacerHUD/models.txt");
+
+    // The manifest may override the quad tree settings
+    config.staticQuadFaces =
+        loader.GetSetting("static.quad.maxfacecount", config.staticQuadFaces);
+    config.staticQuadSize =
+        loader.GetSetting("static.quad.maxquadsize", config.staticQuadSize);
+    config.physicsSettings.quadMaxFaceCount =
+        loader.GetSetting("physic.quad.maxfacecount",
+                          config.physicsSettings.quadMaxFaceCount);
+    config.physicsSettings.quadMaxQuadSize =
+        loader.GetSetting("physic.quad.maxquadsize",
+                          config.physicsSettings.quadMaxQuadSize);
+
+    // The static scene comes from the baked package when it matches
+    // the static models and settings
+    config.scenePackage =
+        new ScenePackage(config.cacheDirectory + "oeracer-scene.pkg");
+    vector<ModelEntry>& entries = loader.GetEntries();
+    for (unsigned int i = 0; i < entries.size(); i++)
+        if (entries[i].section == ModelEntry::STATIC)
+            config.scenePackage->AddSource(entries[i].file);
+    config.scenePackage->AddParameter("quad.maxfacecount", config.staticQuadFaces);
+    config.scenePackage->AddParameter("quad.maxquadsize", config.staticQuadSize);
+    config.startup->Begin("ScenePackage", "load");
+    bool packaged = !config.bakeScene &&
+        config.scenePackage->Load(*config.staticScene);
+    config.startup->End();
+    if (packaged) {
+        logger.info << "Loaded the static scene from "
+                    << config.scenePackage->GetFileName() << logger.end;
+        loader.RemoveSection(ModelEntry::STATIC);
+    }
 
-        // switch to static elements
-        if (mod_str == "dynamic") {
+    config.startup->Begin("ModelLoader", "load");
+    unsigned int loadStart = config.startup->GetTime();
+    loader.Load();
+    for (unsigned int i = 0; i < entries.size(); i++)
+        config.startup->Add(entries[i].file, "model", entries[i].loadTime,
+                            loadStart + entries[i].loadStart);
+    config.startup->End();
+    logger.info << "Loaded " << loader.GetEntries().size() << " models in "
+                << loader.GetLoadTime() / 1000 << " ms using "
+                << loader.GetThreadCount() << " loader threads" << logger.end;
+    const GeometryCache& geometry = loader.GetGeometryCache();
+    if (geometry.GetSharedCount() != 0)
+        logger.info << "Shared the geometry of " << geometry.GetSharedCount()
+                    << " repeated models, saving "
+                    << geometry.GetSavedBytes() / 1024 << " kb" << logger.end;
+
+    // Attach the models to the scene in manifest order
+    for (unsigned int i = 0; i < entries.size(); i++) {
+        if (entries[i].node == NULL) continue;
+        ISceneNode* mod_node = entries[i].node;
+        bool dynamic = false;
+        switch (entries[i].section) {
+        case ModelEntry::DEFAULT:
+            current = config.dynamicScene;
+            break;
+        case ModelEntry::DYNAMIC:
             dynamic = true;
             current = config.dynamicScene;
-            continue;
-        }
-        else if (mod_str == "static") {
-            dynamic = false;
+            break;
+        case ModelEntry::STATIC:
             current = config.staticScene;
-            continue;
-        }
-        else if (mod_str == "physic") {
-            dynamic = false;
+            break;
+        case ModelEntry::PHYSIC:
             current = config.physicScene;
-            continue;
+            config.physicFiles.push_back(entries[i].file);
+            break;
         }
-        
-        // Load the model
-        IModelResourcePtr mod_res = ResourceManager<IModelResource>::Create(mod_str);
-        mod_res->Load();
-        if (mod_res->GetSceneNode() == NULL) continue;
-
-        ISceneNode* mod_node = mod_res->GetSceneNode();
-        mod_res->Unload();
 
         TransformationNode* mod_tran = new TransformationNode();
         mod_tran->AddNode(mod_node);
@@ -409,7 +995,14 @@ void SetupScene(Config& config) {
             // Load riget-box
             config.physicBody = new RigidBox( Box(*mod_node));
             config.physicBody->SetCenter( position );
-            config.physicBody->SetTransformationNode(mod_tran);
+            // With threaded physics the box moves a private node and
+            // the render thread moves the scene node
+            if (config.physicsRate != 0)
+                config.physicBody->SetTransformationNode(new TransformationNode());
+            else
+                config.physicBody->SetTransformationNode(mod_tran);
+            config.vehicleNode = mod_tran;
+            config.vehicleModel = mod_node;
 	    config.physicBody->SetGravity(Vector<3,float>(0, -9.82*20, 0));
             // Bind the follow camera
             config.camera->SetPosition(position + Vector<3,float>(-150,40,0));
@@ -423,41 +1016,85 @@ void SetupScene(Config& config) {
             mod_tran->AddNode(pln);
         }
         current->AddNode(mod_tran);
-        logger.info << "Successfully loaded " << mod_str << logger.end;
+        logger.info << "Successfully loaded " << entries[i].file << logger.end;
     }
-    mfile->close();
-    delete mfile;
-
-    QuadTransformer quadT;
-    quadT.SetMaxFaceCount(500);
-    quadT.SetMaxQuadSize(100);
-    quadT.Transform(*config.staticScene);
 
+    if (!packaged) {
+        QuadTransformer quadT;
+        quadT.SetMaxFaceCount(config.staticQuadFaces);
+        quadT.SetMaxQuadSize(config.staticQuadSize);
+        config.startup->Begin("QuadTransformer", "transformer");
+        quadT.Transform(*config.staticScene);
+        config.startup->End();
+    }
 
-    
-    // HUD
-
-  CairoSurfaceResourcePtr sr = 
-      CairoSurfaceResourcePtr(new CairoSurfaceResource(CairoSurfaceResource::CreateCairoSurface(1024,128)));
-
-  
-  TextSurface *ts = new TextSurface(*sr, string("Hmm"));
-
-  LayerNode *ln = new LayerNode(1024, 768); 
-  Layer layer(0,0);
-  
-    //babeLayer.texr = ResourceManager<ITextureResource>::Create("hud.tga");
-  layer.texr = sr;
-  ln->AddLayer(layer); // = sr; //ResourceManager<ITextureResource>::Create("hud.tga");
-  //ln->AddLayer(*layerStat);
-  //ln->AddLayer(babeLayer);
-  config.renderingScene->AddNode(ln);
-  
+    // Simplified levels of the static quad cells, picked by the
+    // distance to the camera
+    if (config.levelOfDetail && !config.bakeScene) {
+        config.startup->Begin("LODSelector", "transformer");
+        config.lod = new LODSelector(*config.camera);
+        config.lod->Build(*config.staticScene);
+        config.startup->End();
+        config.engine.InitializeEvent().Attach(*config.lod);
+        // The follow camera takes its position from the vehicle node
+        AttachProcess(config, *config.lod, "LODSelector",
+                      TaskScheduler::CAMERA | TaskScheduler::VEHICLE,
+                      TaskScheduler::SCENE);
+        config.engine.DeinitializeEvent().Attach(*config.lod);
+    }
 
-  LayerStatistics* layerStat = new LayerStatistics(1000000, ts);
-  config.engine.ProcessEvent().Attach(*layerStat);
+    // One indexed draw per material in each static quad cell, or in
+    // each level of detail of it
+    if (config.batchStatic && !config.bakeScene) {
+        config.startup->Begin("StaticBatcher", "transformer");
+        StaticBatcher batcher;
+        if (config.lod != NULL)
+            batcher.Batch(*config.staticScene, config.lod->GetDetachedLevels());
+        else
+            batcher.Batch(*config.staticScene);
+        config.startup->End();
+    }
 
 
+    
+    // HUD
+    cairo_surface_t* hudSurface = CairoSurfaceResource::CreateCairoSurface(1024,128);
+    CairoSurfaceResourcePtr sr =
+        CairoSurfaceResourcePtr(new CairoSurfaceResource(hudSurface));
+
+    LayerNode *ln = new LayerNode(1024, 768);
+    Layer layer(0,0);
+    layer.texr = sr;
+    ln->AddLayer(layer);
+    config.renderingScene->AddNode(ln);
+
+    // The panel repaints changed widgets only, and only the repainted
+    // region is uploaded to the layer texture.
+    config.hud = new HUDPanel(hudSurface);
+    if (!config.headless)
+        config.hud->RegionChangedEvent().Attach(*(new HUDTextureUploader(sr, hudSurface)));
+    HUDStatistics* hudStat = new HUDStatistics(*config.hud, config.vehicleNode);
+    config.engine.InitializeEvent().Attach(*hudStat);
+    AttachProcess(config, *hudStat, "HUDStatistics",
+                  TaskScheduler::VEHICLE, TaskScheduler::HUD);
+    config.engine.InitializeEvent().Attach(*config.hud);
+    // The uploader of a displayed HUD uses the GL context
+    AttachProcess(config, *config.hud, "HUDPanel", 0,
+                  config.headless ? TaskScheduler::HUD
+                  : TaskScheduler::HUD | TaskScheduler::DISPLAY);
+
+    // Trade view distance, HUD refreshes and detail for frame time
+    if (config.targetFrameTime != 0 && !config.headless) {
+        QualityGovernor* governor = new QualityGovernor(config.targetFrameTime);
+        governor->SetFrustum(config.frustum);
+        governor->SetHUD(config.hud);
+        governor->SetLOD(config.lod);
+        config.engine.InitializeEvent().Attach(*governor);
+        AttachProcess(config, *governor, "QualityGovernor", 0,
+                      TaskScheduler::CAMERA | TaskScheduler::HUD |
+                      TaskScheduler::SCENE | TaskScheduler::LOG);
+        config.engine.DeinitializeEvent().Attach(*governor);
+    }
 }
 
 void SetupDebugging(Config& config) {
@@ -474,7 +1111,8 @@ void SetupDebugging(Config& config) {
     }
 
     // Add Statistics module
-    config.engine.ProcessEvent().Attach(*(new OpenEngine::Utils::Statistics(1000)));
+    AttachProcess(config, *(new OpenEngine::Utils::Statistics(1000)), "Statistics",
+                  0, TaskScheduler::LOG);
 
     // Create dot graphs of the various scene graphs
     map<string, ISceneNode*> scenes;
@@ -497,3 +1135,448 @@ void SetupDebugging(Config& config) {
         }
     }
 }
+
+void BenchmarkLoading(Config& config, unsigned int threads) {
+    if (config.resourcesLoaded == false)
+        throw Exception("Benchmark loading dependencies are not satisfied.");
+
+    // The first run only warms up the file system caches.
+    unsigned int times[3];
+    unsigned int freeTime = 0;
+    unsigned int runThreads[3] = { 0, 0, threads };
+    for (unsigned int run = 0; run < 3; run++) {
+        ModelLoader loader(runThreads[run]);
+        loader.ReadManifest("projects/OERacerHUD/models.txt");
+        loader.Load();
+        times[run] = loader.GetLoadTime();
+        Timer timer;
+        timer.Start();
+        vector<ModelEntry>& entries = loader.GetEntries();
+        for (unsigned int i = 0; i < entries.size(); i++)
+            delete entries[i].node;
+        freeTime = timer.GetElapsedTime().AsInt();
+    }
+    logger.info << "Model loading, serial:   " << times[1] / 1000 << " ms" << logger.end;
+    logger.info << "Model loading, " << threads << " threads: "
+                << times[2] / 1000 << " ms, freed in "
+                << freeTime / 1000 << " ms" << logger.end;
+    if (times[2] != 0)
+        logger.info << "Model loading speedup: "
+                    << (float)times[1] / times[2] << "x" << logger.end;
+
+    // Once more into an arena, which is dropped in one call. Lazily
+    // created engine state is in place after the runs above, and the
+    // startup does not continue after the benchmark, so nothing still
+    // used is left in the arena.
+    if (config.sceneArena == 0 ||
+        !SceneArena::Reserve((unsigned long)config.sceneArena << 20))
+        return;
+    unsigned int arenaTime;
+    SceneArena::Begin();
+    {
+        ModelLoader loader(threads);
+        loader.ReadManifest("projects/OERacerHUD/models.txt");
+        loader.Load();
+        arenaTime = loader.GetLoadTime();
+    }
+    SceneArena::End();
+    unsigned long used = SceneArena::GetUsed();
+    unsigned long overflows = SceneArena::GetOverflowCount();
+    Timer timer;
+    timer.Start();
+    SceneArena::Release();
+    logger.info << "Model loading, " << threads << " threads into the arena: "
+                << arenaTime / 1000 << " ms, " << used / 1024 << " kb used, "
+                << overflows << " allocations did not fit, freed in "
+                << timer.GetElapsedTime().AsInt() << " usec" << logger.end;
+}
+
+void BenchmarkHUD(unsigned int updates) {
+    cairo_surface_t* surface = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, 1024, 128);
+    HUDPanel panel(surface, 14.0, 0);
+    unsigned int widgets[4];
+    for (unsigned int i = 0; i < 4; i++)
+        widgets[i] = panel.AddWidget(8 + i * 250, 4, 240, 20);
+
+    // Each update changes one widget, like a counter ticking.
+    Timer timer;
+    timer.Start();
+    for (unsigned int i = 0; i < updates; i++) {
+        std::ostringstream text;
+        text << "Value: " << i;
+        panel.SetText(widgets[i % 4], text.str());
+        panel.Refresh();
+    }
+    unsigned int elapsed = timer.GetElapsedTime().AsInt();
+
+    logger.info << "HUD: " << updates << " updates in " << elapsed / 1000
+                << " ms (" << (elapsed ? updates * 1000000.0f / elapsed : 0)
+                << " updates/s, " << panel.GetGlyphCount()
+                << " cached glyphs)" << logger.end;
+    cairo_surface_destroy(surface);
+}
+
+void BenchmarkLogging(string directory, unsigned int messages) {
+    // Both loggers write to the same file, one after the other. The
+    // console logger is off meanwhile.
+    string file = directory + "oeracer-logbench.log";
+    std::ofstream out(file.c_str());
+    StreamLogger* stream = new StreamLogger(&out);
+    AsyncLogger* async = new AsyncLogger(&out);
+    ILogger* loggers[2] = { stream, async };
+    unsigned int elapsed[2];
+    Logger::RemoveLogger(consoleLogger);
+    for (unsigned int l = 0; l < 2; l++) {
+        Logger::AddLogger(loggers[l]);
+        Timer timer;
+        timer.Start();
+        for (unsigned int i = 0; i < messages; i++)
+            logger.info << "Benchmark message " << i << " of " << messages
+                        << logger.end;
+        elapsed[l] = timer.GetElapsedTime().AsInt();
+        Logger::RemoveLogger(loggers[l]);
+    }
+    Timer timer;
+    timer.Start();
+    async->Stop();
+    unsigned int drain = timer.GetElapsedTime().AsInt();
+    Logger::AddLogger(consoleLogger);
+
+    logger.info << "Logging, stream: " << (float)elapsed[0] / messages
+                << " usec/call" << logger.end;
+    logger.info << "Logging, async:  " << (float)elapsed[1] / messages
+                << " usec/call, " << async->GetDroppedCount()
+                << " dropped, " << drain / 1000 << " ms to drain" << logger.end;
+    delete async;
+    delete stream;
+}
+
+void BenchmarkVehicles(unsigned int maxVehicles) {
+    const unsigned int steps = 1000;
+    const float dt = 0.01f;
+    for (unsigned int n = 1; n <= maxVehicles; n *= 10) {
+        VehicleSwarm swarm;
+        TrafficModule traffic(swarm, dt);
+        unsigned int side = (unsigned int)ceil(sqrt((float)n));
+        for (unsigned int i = 0; i < n; i++)
+            swarm.Add((i % side) * 40.0f, 20.0f, (i / side) * 40.0f);
+
+        unsigned long long tests = 0;
+        Timer timer;
+        timer.Start();
+        for (unsigned int i = 0; i < steps; i++) {
+            traffic.Update();
+            tests += swarm.GetPairTests();
+        }
+        unsigned int elapsed = timer.GetElapsedTime().AsInt();
+
+        logger.info << "Vehicles: " << n
+                    << " bodies, " << (float)elapsed / steps << " usec/step, "
+                    << tests / steps << " pair tests/step (all pairs: "
+                    << n * (n - 1) / 2 << ")" << logger.end;
+    }
+}
+
+void TuneQuads(Config& config) {
+    if (config.resourcesLoaded == false)
+        throw Exception("Tune quads dependencies are not satisfied.");
+
+    const unsigned int faceCounts[] = { 100, 250, 500, 1000, 2000 };
+    const unsigned int quadSizes[] = { 50, 100, 200, 400 };
+    QuadTuner tuner("projects/OERacerHUD/models.txt", config.loadThreads);
+    for (unsigned int i = 0; i < 5; i++)
+        tuner.AddFaceCount(faceCounts[i]);
+    for (unsigned int i = 0; i < 4; i++)
+        tuner.AddQuadSize(quadSizes[i]);
+
+    logger.info << "Tuning the static scene quad tree" << logger.end;
+    tuner.Run(ModelEntry::STATIC);
+    QuadTuneResult stat = tuner.GetBest();
+    logger.info << "Tuning the physics quad tree" << logger.end;
+    tuner.Run(ModelEntry::PHYSIC);
+    QuadTuneResult phys = tuner.GetBest();
+
+    logger.info << "Best settings, add these to models.txt:" << logger.end;
+    logger.info << "set static.quad.maxfacecount " << stat.maxFaceCount << logger.end;
+    logger.info << "set static.quad.maxquadsize " << stat.maxQuadSize << logger.end;
+    logger.info << "set physic.quad.maxfacecount " << phys.maxFaceCount << logger.end;
+    logger.info << "set physic.quad.maxquadsize " << phys.maxQuadSize << logger.end;
+}
+
+void BenchmarkCulling(Config& config, unsigned int runs) {
+    if (config.resourcesLoaded == false)
+        throw Exception("Benchmark culling dependencies are not satisfied.");
+
+    // The static scene as SetupScene builds it
+    ModelLoader loader(config.loadThreads);
+    loader.ReadManifest("projects/OERacerHUD/models.txt");
+    loader.SelectSection(ModelEntry::STATIC);
+    loader.Load();
+    SceneNode* scene = new SceneNode();
+    vector<ModelEntry>& entries = loader.GetEntries();
+    for (unsigned int i = 0; i < entries.size(); i++) {
+        if (entries[i].node == NULL) continue;
+        TransformationNode* tran = new TransformationNode();
+        tran->AddNode(entries[i].node);
+        scene->AddNode(tran);
+    }
+    QuadTransformer quadT;
+    quadT.SetMaxFaceCount(loader.GetSetting("static.quad.maxfacecount",
+                                            config.staticQuadFaces));
+    quadT.SetMaxQuadSize(loader.GetSetting("static.quad.maxquadsize",
+                                           config.staticQuadSize));
+    quadT.Transform(*scene);
+
+    SceneBounds bounds;
+    bounds.Build(*scene);
+
+    // The frustum of SetupDisplay along a path around the track
+    const unsigned int steps = QuadTuner::PATH_LENGTH;
+    const float up[3] = { 0, 1, 0 };
+    vector<ViewFrustum> path;
+    for (unsigned int i = 0; i < steps; i++) {
+        float pos[3], dir[3];
+        bounds.Orbit((float)i / steps, 40, pos, dir);
+        path.push_back(ViewFrustum::Look(pos, dir, up,
+                                         OpenEngine::Math::PI / 4,
+                                         4.0f / 3.0f, 20, 3000));
+    }
+
+    unsigned long long visible[2] = { 0, 0 };
+    unsigned int elapsed[2];
+    vector<unsigned char> inside;
+    Timer timer;
+    timer.Start();
+    for (unsigned int r = 0; r < runs; r++)
+        for (unsigned int i = 0; i < steps; i++)
+            visible[0] += bounds.Cull(path[i]);
+    elapsed[0] = timer.GetElapsedTime().AsInt();
+    timer.Reset();
+    timer.Start();
+    for (unsigned int r = 0; r < runs; r++)
+        for (unsigned int i = 0; i < steps; i++)
+            visible[1] += bounds.CullBatch(path[i], inside);
+    elapsed[1] = timer.GetElapsedTime().AsInt();
+
+    logger.info << "Culling " << bounds.Size() << " nodes, "
+                << bounds.GetFaceCount() << " faces, "
+                << visible[0] / (runs * steps) << " faces visible" << logger.end;
+    logger.info << "Culling, per node: " << (float)elapsed[0] / (runs * steps)
+                << " usec/frustum" << logger.end;
+    logger.info << "Culling, batched:  " << (float)elapsed[1] / (runs * steps)
+                << " usec/frustum" << logger.end;
+    if (visible[0] != visible[1])
+        logger.error << "Batched culling disagrees with per node culling"
+                     << logger.end;
+    delete scene;
+}
+
+// Box query on the quad level of a physics tree: the overlapping
+// nodes are found through the bounds, and their faces are tested
+// through the face lists of the scene graph.
+unsigned int QueryFaceLists(const SceneBounds& bounds,
+                            const float min[3], const float max[3]) {
+    unsigned int found = 0;
+    const unsigned int n = bounds.Size();
+    unsigned int i = 0;
+    while (i < n) {
+        if (bounds.minX[i] > max[0] || bounds.maxX[i] < min[0] ||
+            bounds.minY[i] > max[1] || bounds.maxY[i] < min[1] ||
+            bounds.minZ[i] > max[2] || bounds.maxZ[i] < min[2]) {
+            i = bounds.skip[i];
+            continue;
+        }
+        GeometryNode* geom = dynamic_cast<GeometryNode*>(bounds.nodes[i]);
+        if (geom != NULL && geom->GetFaceSet() != NULL) {
+            OpenEngine::Geometry::FaceSet* fs = geom->GetFaceSet();
+            OpenEngine::Geometry::FaceList::iterator itr;
+            for (itr = fs->begin(); itr != fs->end(); itr++) {
+                bool overlaps = true;
+                for (int k = 0; k < 3 && overlaps; k++) {
+                    float lo = std::min((*itr)->vert[0][k],
+                               std::min((*itr)->vert[1][k], (*itr)->vert[2][k]));
+                    float hi = std::max((*itr)->vert[0][k],
+                               std::max((*itr)->vert[1][k], (*itr)->vert[2][k]));
+                    overlaps = lo <= max[k] && hi >= min[k];
+                }
+                if (overlaps) found++;
+            }
+        }
+        i++;
+    }
+    return found;
+}
+
+void BenchmarkCollision(Config& config, unsigned int runs) {
+    if (config.resourcesLoaded == false)
+        throw Exception("Benchmark collision dependencies are not satisfied.");
+
+    // The physic models as SetupScene loads them
+    ModelLoader loader(config.loadThreads);
+    loader.ReadManifest("projects/OERacerHUD/models.txt");
+    loader.SelectSection(ModelEntry::PHYSIC);
+    loader.Load();
+    SceneNode* scene = new SceneNode();
+    CollisionTree tree;
+    ContentKey key;
+    key.AddParameter("collision.leafsize", tree.GetLeafSize());
+    vector<ModelEntry>& entries = loader.GetEntries();
+    for (unsigned int i = 0; i < entries.size(); i++) {
+        key.AddSource(entries[i].file);
+        if (entries[i].node == NULL) continue;
+        TransformationNode* tran = new TransformationNode();
+        tran->AddNode(entries[i].node);
+        scene->AddNode(tran);
+    }
+
+    // The collision tree, from its file if it is up to date
+    string file = config.cacheDirectory + "oeracer-collision.bin";
+    Timer timer;
+    timer.Start();
+    if (tree.Load(file, key.Get())) {
+        logger.info << "Collision tree loaded in "
+                    << timer.GetElapsedTime().AsInt() / 1000 << " ms" << logger.end;
+    } else {
+        tree.Build(*scene);
+        logger.info << "Collision tree built in "
+                    << timer.GetElapsedTime().AsInt() / 1000 << " ms" << logger.end;
+        tree.Save(file, key.Get());
+    }
+
+    // The hybrid tree of SetupPhysics, queried on the quad level
+    CollectedGeometryTransformer collT;
+    QuadTransformer quadT;
+    unsigned int maxFaceCount = loader.GetSetting("physic.quad.maxfacecount", 0);
+    unsigned int maxQuadSize = loader.GetSetting("physic.quad.maxquadsize", 0);
+    if (maxFaceCount != 0) quadT.SetMaxFaceCount(maxFaceCount);
+    if (maxQuadSize != 0) quadT.SetMaxQuadSize(maxQuadSize);
+    timer.Reset();
+    timer.Start();
+    collT.Transform(*scene);
+    quadT.Transform(*scene);
+    logger.info << "Quad tree built in "
+                << timer.GetElapsedTime().AsInt() / 1000 << " ms" << logger.end;
+    SceneBounds bounds;
+    bounds.Build(*scene);
+
+    // A vehicle sized box along a path around the track
+    const unsigned int steps = QuadTuner::PATH_LENGTH;
+    vector<float> boxes;
+    for (unsigned int i = 0; i < steps; i++) {
+        float pos[3], dir[3];
+        bounds.Orbit((float)i / steps, 20, pos, dir);
+        for (int k = 0; k < 3; k++) boxes.push_back(pos[k] - 20);
+        for (int k = 0; k < 3; k++) boxes.push_back(pos[k] + 20);
+    }
+
+    unsigned long long found[2] = { 0, 0 };
+    unsigned int elapsed[2];
+    timer.Reset();
+    timer.Start();
+    for (unsigned int r = 0; r < runs; r++)
+        for (unsigned int i = 0; i < steps; i++)
+            found[0] += QueryFaceLists(bounds, &boxes[i*6], &boxes[i*6+3]);
+    elapsed[0] = timer.GetElapsedTime().AsInt();
+    timer.Reset();
+    timer.Start();
+    for (unsigned int r = 0; r < runs; r++)
+        for (unsigned int i = 0; i < steps; i++)
+            found[1] += tree.QueryBox(&boxes[i*6], &boxes[i*6+3]);
+    elapsed[1] = timer.GetElapsedTime().AsInt();
+
+    // Ground height under the path
+    const float down[3] = { 0, -1, 0 };
+    unsigned int hits = 0;
+    timer.Reset();
+    timer.Start();
+    for (unsigned int r = 0; r < runs; r++)
+        for (unsigned int i = 0; i < steps; i++) {
+            float origin[3] = { boxes[i*6] + 20, boxes[i*6+4], boxes[i*6+2] + 20 };
+            float distance = 1000;
+            if (tree.RayCast(origin, down, distance)) hits++;
+        }
+    unsigned int rayTime = timer.GetElapsedTime().AsInt();
+
+    const float queries = (float)runs * steps;
+    // The quad cells hold the faces split on their borders, so the two
+    // counts are not expected to agree
+    logger.info << "Collision tree: " << tree.GetNodeCount() << " nodes, "
+                << tree.GetTriangleCount() << " triangles, "
+                << tree.GetMemory() / 1024 << " kb, "
+                << found[1] / (runs * steps) << " triangles/query"
+                << logger.end;
+    logger.info << "Quad tree: " << bounds.Size() << " nodes, "
+                << bounds.GetFaceCount() << " faces, "
+                << found[0] / (runs * steps) << " faces/query" << logger.end;
+    logger.info << "Box queries, quad tree:      "
+                << queries * 1000000 / std::max(elapsed[0], 1u)
+                << " queries/sec" << logger.end;
+    logger.info << "Box queries, collision tree: "
+                << queries * 1000000 / std::max(elapsed[1], 1u)
+                << " queries/sec" << logger.end;
+    logger.info << "Ray casts, collision tree:   "
+                << queries * 1000000 / std::max(rayTime, 1u)
+                << " queries/sec, " << hits * 100 / (runs * steps)
+                << "% hit the ground" << logger.end;
+    delete scene;
+}
+
+// Build the physics tree serially and on 1 to threads workers. Every
+// tree is serialized and compared byte for byte with the serial one.
+void BenchmarkPhysicsTree(Config& config, unsigned int threads) {
+    if (config.resourcesLoaded == false)
+        throw Exception("Benchmark physics tree dependencies are not satisfied.");
+
+    string file = config.cacheDirectory + "oeracer-treebench.bin";
+    string reference;
+    unsigned int serial = 0;
+    for (unsigned int t = 0; t <= threads; t++) {
+        // The physic models as SetupScene loads them
+        ModelLoader loader(config.loadThreads);
+        loader.ReadManifest("projects/OERacerHUD/models.txt");
+        PhysicsTreeSettings settings;
+        settings.quadMaxFaceCount =
+            loader.GetSetting("physic.quad.maxfacecount", 0);
+        settings.quadMaxQuadSize =
+            loader.GetSetting("physic.quad.maxquadsize", 0);
+        loader.SelectSection(ModelEntry::PHYSIC);
+        loader.Load();
+        SceneNode* scene = new SceneNode();
+        vector<ModelEntry>& entries = loader.GetEntries();
+        for (unsigned int i = 0; i < entries.size(); i++) {
+            if (entries[i].node == NULL) continue;
+            TransformationNode* tran = new TransformationNode();
+            tran->AddNode(entries[i].node);
+            scene->AddNode(tran);
+        }
+
+        PhysicsTreeBuilder builder(settings, t);
+        builder.Build(*scene);
+
+        std::ofstream out(file.c_str(), std::ios::binary);
+        Serialization::Serialize(*scene, &out);
+        out.close();
+        std::ifstream in(file.c_str(), std::ios::binary);
+        std::ostringstream bytes;
+        bytes << in.rdbuf();
+        delete scene;
+
+        unsigned int time = builder.GetBuildTime();
+        if (t == 0) {
+            reference = bytes.str();
+            serial = time;
+            logger.info << "Physics tree, serial: " << time / 1000 << " ms (quad "
+                        << builder.GetQuadTime() / 1000 << " ms, bsp "
+                        << builder.GetBSPTime() / 1000 << " ms), "
+                        << reference.size() / 1024 << " kb" << logger.end;
+            continue;
+        }
+        logger.info << "Physics tree, " << t << " threads: " << time / 1000
+                    << " ms (bsp " << builder.GetBSPTime() / 1000 << " ms, "
+                    << builder.GetJobCount() << " jobs), speedup "
+                    << (time ? (float)serial / time : 0) << "x, "
+                    << (bytes.str() == reference ? "identical" : "DIFFERS")
+                    << logger.end;
+    }
+    remove(file.c_str());
+}